@@ -16,11 +16,24 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
   EventLoop _eventloop {};
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
-  ByteStream _outbound { buffer_size };
-  ByteStream _inbound { buffer_size };
+  ByteStream _outbound { buffer_size, ByteStream::Storage::Mirrored };
+  ByteStream _inbound { buffer_size, ByteStream::Storage::Mirrored };
   bool _outbound_shutdown { false };
   bool _inbound_shutdown { false };
 
+  // Interest in each fd is armed and disarmed on watermark edges rather than recomputed from the streams:
+  // a reader stays asleep until its stream has data, and a writer that fills its stream waits until an
+  // eighth of it has drained instead of waking for every few bytes the other side manages to write.
+  constexpr uint64_t low_mark = buffer_size / 8;
+  bool _outbound_has_space { true };
+  bool _outbound_has_data { false };
+  bool _inbound_has_space { true };
+  bool _inbound_has_data { false };
+  _outbound.writer().on_capacity_above( low_mark, [&] { _outbound_has_space = true; } );
+  _outbound.reader().on_buffered_above( 1, [&] { _outbound_has_data = true; } );
+  _inbound.writer().on_capacity_above( low_mark, [&] { _inbound_has_space = true; } );
+  _inbound.reader().on_buffered_above( 1, [&] { _inbound_has_data = true; } );
+
   socket.set_blocking( false );
   _input.set_blocking( false );
   _output.set_blocking( false );
@@ -31,16 +44,14 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     _input,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _outbound.writer().available_capacity() );
-      _input.read( data );
-      _outbound.writer().push( move( data ) );
+      _outbound.writer().push_from_fd( _input );
+      _outbound_has_space = _outbound.writer().available_capacity() > 0;
       if ( _input.eof() ) {
         _outbound.writer().close();
       }
     },
     [&] {
-      return !_outbound.has_error() and !_inbound.has_error() and ( _outbound.writer().available_capacity() > 0 )
+      return !_outbound.has_error() and !_inbound.has_error() and _outbound_has_space
              and !_outbound.writer().is_closed();
     },
     [&] { _outbound.writer().close(); },
@@ -57,8 +68,9 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     Direction::Out,
     [&] {
       if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
+        _outbound.reader().pop( socket.write( _outbound.reader().peek_iov() ) );
       }
+      _outbound_has_data = _outbound.reader().bytes_buffered() > 0;
       if ( _outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
         _outbound_shutdown = true;
@@ -66,7 +78,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
       }
     },
     [&] {
-      return _outbound.reader().bytes_buffered() or ( _outbound.reader().is_finished() and not _outbound_shutdown );
+      return _outbound_has_data or ( _outbound.reader().is_finished() and not _outbound_shutdown );
     },
     [&] { _outbound.writer().close(); },
     [&] {
@@ -81,16 +93,14 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     socket,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _inbound.writer().available_capacity() );
-      socket.read( data );
-      _inbound.writer().push( move( data ) );
+      _inbound.writer().push_from_fd( socket );
+      _inbound_has_space = _inbound.writer().available_capacity() > 0;
       if ( socket.eof() ) {
         _inbound.writer().close();
       }
     },
     [&] {
-      return !_inbound.has_error() and !_outbound.has_error() and ( _inbound.writer().available_capacity() > 0 )
+      return !_inbound.has_error() and !_outbound.has_error() and _inbound_has_space
              and !_inbound.writer().is_closed();
     },
     [&] { _inbound.writer().close(); },
@@ -107,8 +117,9 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     Direction::Out,
     [&] {
       if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
+        _inbound.reader().pop( _output.write( _inbound.reader().peek_iov() ) );
       }
+      _inbound_has_data = _inbound.reader().bytes_buffered() > 0;
       if ( _inbound.reader().is_finished() ) {
         _output.close();
         _inbound_shutdown = true;
@@ -117,7 +128,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
       }
     },
     [&] {
-      return _inbound.reader().bytes_buffered() or ( _inbound.reader().is_finished() and not _inbound_shutdown );
+      return _inbound_has_data or ( _inbound.reader().is_finished() and not _inbound_shutdown );
     },
     [&] { _inbound.writer().close(); },
     [&] {
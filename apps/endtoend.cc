@@ -73,9 +73,7 @@ optional<EthernetFrame> maybe_receive_frame( FileDescriptor& fd )
   fd.read( strs );
 
   EthernetFrame frame;
-  vector<string> buffers;
-  ranges::transform( strs, back_inserter( buffers ), identity() );
-  if ( not parse( frame, buffers ) ) {
+  if ( not parse( frame, to_slices( std::move( strs ) ) ) ) {
     return {};
   }
 
@@ -1,4 +1,5 @@
 #include "bidirectional_stream_copy.hh"
+#include "mapped_file.hh"
 #include "tcp_config.hh"
 #include "tcp_minnow_socket.hh"
 #include "tun.hh"
@@ -7,9 +8,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <span>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 using namespace std;
@@ -35,8 +38,18 @@ void show_usage( const char* argv0, const char* msg )
 
        << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+       << "   -c <algo>       Congestion control: none, newreno, cubic or bbr (newreno)\n\n"
+
+       << "   -N              Send short segments at once (TCP_NODELAY)       (Nagle)\n"
+       << "   -C              Autocork short segments instead of Nagle        (Nagle)\n\n"
+
+       << "   -m <mtu>        Set the link MTU (9000 for jumbo frames)        1500\n"
+       << "   -P              Don't probe for the path MTU (RFC 4821)         (probe)\n\n"
+
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
 
+       << "   -f <file>       Send <file> (memory-mapped) instead of stdin    (stdin)\n\n"
+
        << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
        << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
@@ -56,13 +69,14 @@ void check_argc( const span<char*>& args, size_t curr, const char* err )
   }
 }
 
-tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char*>& args )
+tuple<TCPConfig, FdAdapterConfig, bool, const char*, const char*> get_config( const span<char*>& args )
 {
   TCPConfig c_fsm {};
   c_fsm.isn = Wrap32 { random_device()() };
 
   FdAdapterConfig c_filt {};
   const char* tundev = nullptr;
+  const char* file = nullptr;
 
   size_t curr = 1;
   bool listen = false;
@@ -96,11 +110,55 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-c", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -c requires one argument." );
+      const string_view algo = args[curr + 1];
+      if ( algo == "none" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::None;
+      } else if ( algo == "newreno" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::NewReno;
+      } else if ( algo == "cubic" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::CUBIC;
+      } else if ( algo == "bbr" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::BBR;
+      } else {
+        show_usage( args[0], "ERROR: unknown congestion control algorithm." );
+        exit( 1 );
+      }
+      curr += 2;
+
+    } else if ( strncmp( "-N", args[curr], 3 ) == 0 ) {
+      c_fsm.nodelay = true;
+      curr += 1;
+
+    } else if ( strncmp( "-C", args[curr], 3 ) == 0 ) {
+      c_fsm.coalescing = Coalescing::Autocork;
+      curr += 1;
+
+    } else if ( strncmp( "-m", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -m requires one argument." );
+      c_fsm.mtu = strtol( args[curr + 1], nullptr, 0 );
+      if ( c_fsm.mtu <= TCPConfig::HEADERS_SIZE + TCPConfig::OPTIONS_SIZE ) {
+        show_usage( args[0], "ERROR: MTU too small." );
+        exit( 1 );
+      }
+      curr += 2;
+
+    } else if ( strncmp( "-P", args[curr], 3 ) == 0 ) {
+      c_fsm.mtu_probing = false;
+      curr += 1;
+
     } else if ( strncmp( "-d", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       tundev = args[curr + 1];
       curr += 2;
 
+    } else if ( strncmp( "-f", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -f requires one argument." );
+      file = args[curr + 1];
+      c_fsm.stream_storage = ByteStream::Storage::Chunked; // hold the mapped pages by reference
+      curr += 2;
+
     } else if ( strncmp( "-Lu", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -Lu requires one argument." );
       const float lossrate = strtof( args[curr + 1], nullptr );
@@ -139,7 +197,7 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
     c_filt.source = { source_address, source_port };
   }
 
-  return make_tuple( c_fsm, c_filt, listen, tundev );
+  return make_tuple( c_fsm, c_filt, listen, tundev, file );
 }
 } // namespace
 
@@ -157,17 +215,33 @@ int main( int argc, char** argv )
       return EXIT_FAILURE;
     }
 
-    auto [c_fsm, c_filt, listen, tun_dev_name] = get_config( args );
+    auto [c_fsm, c_filt, listen, tun_dev_name, file] = get_config( args );
     LossyTCPOverIPv4MinnowSocket tcp_socket( LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>(
       TCPOverIPv4OverTunFdAdapter( TunFD( tun_dev_name == nullptr ? TUN_DFLT : tun_dev_name ) ) ) );
 
+    if ( file != nullptr ) {
+      tcp_socket.send_file( make_shared<const MappedFile>( string( file ) ) );
+    }
+
     if ( listen ) {
       tcp_socket.listen_and_accept( c_fsm, c_filt );
     } else {
       tcp_socket.connect( c_fsm, c_filt );
     }
 
-    bidirectional_stream_copy( tcp_socket, tcp_socket.peer_address().to_string() );
+    if ( file != nullptr ) {
+      // the TCPPeer thread sends the file itself; just copy the inbound stream to stdout
+      tcp_socket.set_blocking( true );
+      string buffer;
+      while ( not tcp_socket.eof() ) {
+        buffer.clear();
+        tcp_socket.read( buffer );
+        cout << buffer;
+      }
+      cout.flush();
+    } else {
+      bidirectional_stream_copy( tcp_socket, tcp_socket.peer_address().to_string() );
+    }
     tcp_socket.wait_until_closed();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
@@ -23,6 +23,14 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_mirrored)
+ttest(byte_stream_chunked)
+ttest(byte_stream_peek_iov)
+ttest(byte_stream_push_from_fd)
+ttest(byte_stream_pooled)
+ttest(byte_stream_watermarks)
+ttest(byte_stream_push_file)
+ttest(spsc_ring)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +39,10 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_direct)
+ttest(reassembler_budget)
+ttest(reassembler_counters)
+ttest(reassembler_sack)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -45,6 +57,11 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
+ttest(tcp_segment_options)
+ttest(buffer_slice)
+ttest(tcp_peer_options)
+ttest(tcp_socket_shared_memory)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +70,13 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_sack)
+ttest(send_congestion)
+ttest(send_rtt)
+ttest(send_fast_retx)
+ttest(send_coalescing)
+ttest(send_mtu_probe)
+ttest(congestion_control)
 
 ttest(net_interface)
 
@@ -90,3 +114,10 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+
+# benchmarks print tables rather than pass or fail, so they stay out of ctest (and `test`, `speed`, checkN)
+add_custom_target (benchmark
+  COMMAND byte_stream_benchmark
+  COMMAND reassembler_benchmark
+  COMMAND lossy_link_benchmark
+  COMMAND coalescing_benchmark)
@@ -1,6 +1,69 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+#include <algorithm>
+#include <stdexcept>
+
+ByteStream::ByteStream( uint64_t capacity, Storage storage )
+  : capacity_( capacity )
+  , storage_( storage )
+  , buffer_( storage == Storage::Ring or storage == Storage::Mirrored ? capacity : 0, storage == Storage::Mirrored )
+{}
+
+ByteStream::Storage ByteStream::storage() const
+{
+  if ( storage_ == Storage::Chunked or storage_ == Storage::Pooled ) {
+    return storage_;
+  }
+  return buffer_.mirrored() ? Storage::Mirrored : Storage::Ring;
+}
+
+std::vector<std::span<char>> ByteStream::slab_free_space( uint64_t len )
+{
+  const uint64_t slab_size = slabs_.empty() ? BufferPool::global().slab_size() : slabs_.front().size();
+
+  // `end` is where the next byte goes, counting from the start of the front slab
+  uint64_t end = front_offset_ + ( pushed_ - popped_ );
+  while ( slabs_.size() * slab_size < end + len ) {
+    slabs_.push_back( BufferPool::global().borrow() );
+  }
+
+  std::vector<std::span<char>> ret;
+  while ( len ) {
+    const uint64_t offset = end % slab_size;
+    const uint64_t n = std::min( len, slab_size - offset );
+    ret.emplace_back( slabs_[end / slab_size].data() + offset, n );
+    end += n;
+    len -= n;
+  }
+  return ret;
+}
+
+void ByteStream::release_slabs()
+{
+  if ( pushed_ == popped_ ) {
+    slabs_.clear();
+    front_offset_ = 0;
+    return;
+  }
+
+  const uint64_t end = front_offset_ + ( pushed_ - popped_ );
+  while ( ( slabs_.size() - 1 ) * slabs_.front().size() >= end ) {
+    slabs_.pop_back();
+  }
+}
+
+void ByteStream::check_watermarks( uint64_t buffered_before )
+{
+  const uint64_t buffered = pushed_ - popped_;
+  if ( buffered_callback_ and buffered_before < buffered_mark_ and buffered >= buffered_mark_ ) {
+    buffered_callback_();
+  }
+  const uint64_t capacity_before = capacity_ - buffered_before;
+  if ( capacity_callback_ and capacity_before < capacity_mark_ and capacity_ - buffered >= capacity_mark_ ) {
+    capacity_callback_();
+  }
+}
 
 bool Writer::is_closed() const
 {
@@ -9,11 +72,151 @@ bool Writer::is_closed() const
 
 void Writer::push( std::string data )
 {
-  uint64_t to_push = std::min( data.size(), available_capacity() );
-  if ( to_push < data.size() )
-    data.erase( to_push ); // Keep only the part to be moved
-  buffer_.append( std::move( data ) );
+  const uint64_t to_push = std::min( data.size(), available_capacity() );
+  if ( to_push == 0 ) {
+    return;
+  }
+
+  if ( storage_ != Storage::Chunked ) {
+    copy_in( std::string_view( data ).substr( 0, to_push ) );
+    return;
+  }
+
+  const uint64_t buffered_before = pushed_ - popped_;
+  data.resize( to_push );
+  if ( data.capacity() > 2 * data.size() ) {
+    data.shrink_to_fit(); // don't let a short chunk pin a much larger allocation
+  }
+  chunks_.push_back( { .owned = std::move( data ) } );
   pushed_ += to_push;
+  check_watermarks( buffered_before );
+}
+
+void Writer::push_view( std::string_view data )
+{
+  if ( storage_ == Storage::Chunked ) {
+    push( std::string { data.substr( 0, available_capacity() ) } );
+    return;
+  }
+
+  const uint64_t to_push = std::min( data.size(), available_capacity() );
+  if ( to_push > 0 ) {
+    copy_in( data.substr( 0, to_push ) );
+  }
+}
+
+uint64_t Writer::push_file( const std::shared_ptr<const MappedFile>& file, uint64_t offset )
+{
+  const std::string_view data
+    = file->view().substr( std::min( offset, file->size() ) ).substr( 0, available_capacity() );
+  if ( data.empty() ) {
+    return 0;
+  }
+
+  if ( storage_ != Storage::Chunked ) {
+    copy_in( data );
+    return data.size();
+  }
+
+  const uint64_t buffered_before = pushed_ - popped_;
+  chunks_.push_back( { .file = file, .mapped = data } );
+  pushed_ += data.size();
+  check_watermarks( buffered_before );
+  return data.size();
+}
+
+void Writer::place( uint64_t offset, std::string_view data )
+{
+  if ( storage_ != Storage::Ring and storage_ != Storage::Mirrored ) {
+    throw std::runtime_error( "Writer::place() needs Ring or Mirrored storage" );
+  }
+  if ( offset + data.size() > available_capacity() ) {
+    throw std::runtime_error( "Writer::place() beyond available capacity" );
+  }
+
+  const uint64_t start = ( pushed_ + offset ) % buffer_.size();
+  const uint64_t first_part
+    = buffer_.mirrored() ? data.size() : std::min<uint64_t>( data.size(), buffer_.size() - start );
+  data.copy( buffer_.data() + start, first_part );
+  data.copy( buffer_.data(), data.size() - first_part, first_part );
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( storage_ != Storage::Ring and storage_ != Storage::Mirrored ) {
+    throw std::runtime_error( "Writer::commit() needs Ring or Mirrored storage" );
+  }
+  if ( len > available_capacity() ) {
+    throw std::runtime_error( "Writer::commit() beyond available capacity" );
+  }
+
+  const uint64_t buffered_before = pushed_ - popped_;
+  pushed_ += len;
+  check_watermarks( buffered_before );
+}
+
+void ByteStream::copy_in( std::string_view data )
+{
+  const uint64_t buffered_before = pushed_ - popped_;
+  if ( storage_ == Storage::Pooled ) {
+    uint64_t copied = 0;
+    for ( const auto region : slab_free_space( data.size() ) ) {
+      copied += data.copy( region.data(), region.size(), copied );
+    }
+  } else {
+    // Copy into the free space after the tail, wrapping around to the start of the ring if needed
+    const uint64_t tail = pushed_ % buffer_.size();
+    const uint64_t first_part
+      = buffer_.mirrored() ? data.size() : std::min<uint64_t>( data.size(), buffer_.size() - tail );
+    data.copy( buffer_.data() + tail, first_part );
+    data.copy( buffer_.data(), data.size() - first_part, first_part );
+  }
+  pushed_ += data.size();
+  check_watermarks( buffered_before );
+}
+
+uint64_t Writer::push_from_fd( FileDescriptor& fd )
+{
+  const uint64_t space = available_capacity();
+  if ( space == 0 ) {
+    return 0;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    // Size the chunk to what's waiting, so push() doesn't have to shrink a short read into a copy
+    const uint64_t waiting = fd.bytes_readable();
+    std::string data( waiting ? std::min( space, waiting ) : space, 0 );
+    data.resize( fd.read( std::vector<std::span<char>> { data } ) );
+    const uint64_t bytes_read = data.size();
+    push( std::move( data ) );
+    return bytes_read;
+  }
+
+  const uint64_t buffered_before = pushed_ - popped_;
+  uint64_t bytes_read = 0;
+  if ( storage_ == Storage::Pooled ) {
+    bytes_read = fd.read( slab_free_space( space ) );
+    pushed_ += bytes_read;
+    release_slabs();
+  } else {
+    // The free space runs from the tail to the end of the ring, then wraps to its start
+    const uint64_t tail = pushed_ % buffer_.size();
+    const uint64_t first_part = buffer_.mirrored() ? space : std::min( space, buffer_.size() - tail );
+    std::vector<std::span<char>> regions { { buffer_.data() + tail, first_part } };
+    if ( first_part < space ) {
+      regions.emplace_back( buffer_.data(), space - first_part );
+    }
+    bytes_read = fd.read( regions );
+    pushed_ += bytes_read;
+  }
+  check_watermarks( buffered_before );
+  return bytes_read;
+}
+
+void Writer::on_capacity_above( uint64_t low_mark, std::function<void()> callback )
+{
+  capacity_mark_ = std::min( low_mark, capacity_ );
+  capacity_callback_ = std::move( callback );
 }
 
 void Writer::close()
@@ -23,7 +226,7 @@ void Writer::close()
 
 uint64_t Writer::available_capacity() const
 {
-  return capacity_ - buffer_.size();
+  return capacity_ - ( pushed_ - popped_ );
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -33,7 +236,7 @@ uint64_t Writer::bytes_pushed() const
 
 bool Reader::is_finished() const
 {
-  return buffer_.empty() && closed_;
+  return closed_ && bytes_buffered() == 0;
 }
 
 uint64_t Reader::bytes_popped() const
@@ -43,17 +246,112 @@ uint64_t Reader::bytes_popped() const
 
 std::string_view Reader::peek() const
 {
-  return std::string_view( buffer_ );
+  return peek( 0 );
+}
+
+std::string_view Reader::peek( uint64_t offset ) const
+{
+  if ( offset >= bytes_buffered() ) {
+    return {};
+  }
+  const uint64_t remaining = bytes_buffered() - offset;
+
+  if ( storage_ == Storage::Chunked ) {
+    offset += front_offset_;
+    auto it = chunks_.begin();
+    while ( offset >= it->size() ) {
+      offset -= it->size();
+      ++it;
+    }
+    return it->view().substr( offset );
+  }
+
+  if ( storage_ == Storage::Pooled ) {
+    // every slab is the same size
+    const uint64_t position = front_offset_ + offset;
+    const uint64_t slab_size = slabs_.front().size();
+    const uint64_t within = position % slab_size;
+    return { slabs_[position / slab_size].data() + within, std::min( remaining, slab_size - within ) };
+  }
+
+  // Without the mirror, only the bytes up to the end of the ring are contiguous
+  const uint64_t head = ( popped_ + offset ) % buffer_.size();
+  const uint64_t len = buffer_.mirrored() ? remaining : std::min( remaining, buffer_.size() - head );
+  return { buffer_.data() + head, len };
+}
+
+std::vector<std::string_view> Reader::peek_iov( size_t max_regions ) const
+{
+  std::vector<std::string_view> ret;
+  if ( bytes_buffered() == 0 or max_regions == 0 ) {
+    return ret;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    ret.reserve( std::min( max_regions, chunks_.size() ) );
+    ret.push_back( peek() );
+    for ( auto it = chunks_.begin() + 1; it != chunks_.end() and ret.size() < max_regions; ++it ) {
+      ret.push_back( it->view() );
+    }
+    return ret;
+  }
+
+  if ( storage_ == Storage::Pooled ) {
+    ret.push_back( peek() );
+    uint64_t remaining = bytes_buffered() - ret.front().size();
+    for ( auto it = slabs_.begin() + 1; remaining and ret.size() < max_regions; ++it ) {
+      ret.emplace_back( it->data(), std::min( remaining, it->size() ) );
+      remaining -= ret.back().size();
+    }
+    return ret;
+  }
+
+  // A ring holds at most two regions: up to the end of the ring, then from its start
+  ret.push_back( peek() );
+  if ( ret.front().size() < bytes_buffered() and max_regions > 1 ) {
+    ret.emplace_back( buffer_.data(), bytes_buffered() - ret.front().size() );
+  }
+  return ret;
+}
+
+void Reader::on_buffered_above( uint64_t threshold, std::function<void()> callback )
+{
+  buffered_mark_ = std::min( threshold, capacity_ );
+  buffered_callback_ = std::move( callback );
 }
 
 void Reader::pop( uint64_t len )
 {
-  uint64_t to_pop = std::min( len, buffer_.size() );
-  buffer_.erase( 0, to_pop );
-  popped_ += to_pop;
+  len = std::min( len, bytes_buffered() );
+  const uint64_t buffered_before = bytes_buffered();
+  popped_ += len;
+
+  if ( storage_ == Storage::Chunked ) {
+    len += front_offset_;
+    while ( len and len >= chunks_.front().size() ) {
+      len -= chunks_.front().size();
+      chunks_.pop_front();
+    }
+    front_offset_ = len;
+  }
+
+  if ( storage_ == Storage::Pooled and len ) {
+    len += front_offset_;
+    while ( len >= slabs_.front().size() ) {
+      len -= slabs_.front().size();
+      slabs_.pop_front();
+      if ( slabs_.empty() ) {
+        break;
+      }
+    }
+    front_offset_ = len;
+    release_slabs();
+  }
+
+  check_watermarks( buffered_before );
 }
 
 uint64_t Reader::bytes_buffered() const
 {
-  return buffer_.size();
+  return pushed_ - popped_;
 }
@@ -1,16 +1,36 @@
 #pragma once
 
+#include "buffer_pool.hh"
+#include "mapped_file.hh"
+#include "ring_storage.hh"
+
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 class Reader;
 class Writer;
+class FileDescriptor;
 
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // Where the stream keeps its buffered bytes
+  enum class Storage : uint8_t
+  {
+    Ring,     // Plain memory: peek() stops at the end of the ring
+    Mirrored, // Ring mapped twice back to back: peek() returns every buffered byte
+    Chunked,  // Pushed strings (and file slices) are kept as-is: peek() returns the rest of the oldest one
+    Pooled,   // Slabs borrowed from BufferPool::global() as data arrives and returned as it drains
+  };
+
+  // Mirrored storage falls back to Ring when memfd/mmap is not available.
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -21,6 +41,8 @@ public:
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
 
+  Storage storage() const; // Which storage the stream actually got
+
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
@@ -29,16 +51,78 @@ protected:
 
   bool error_ {};
   bool closed_ {};
+  Storage storage_;
+
+  // Ring and Mirrored: circular buffer of at least `capacity_` bytes, allocated once. The next byte to read
+  // lives at `popped_ % buffer_.size()` and the next byte to write goes to `pushed_ % buffer_.size()`.
+  RingStorage buffer_;
+
+  // Chunked: the pushed strings themselves, or slices of mapped files, oldest first.
+  struct Chunk
+  {
+    std::string owned {};
+    std::shared_ptr<const MappedFile> file {}; // if set, the chunk is `mapped` rather than `owned`
+    std::string_view mapped {};
+
+    std::string_view view() const { return file ? mapped : owned; }
+    size_t size() const { return view().size(); }
+  };
+  std::deque<Chunk> chunks_ {};
+
+  // Pooled: borrowed slabs, holding the buffered bytes back to back.
+  std::deque<BufferPool::Slab> slabs_ {};
+
+  // Chunked and Pooled: how many bytes of the front chunk or slab have already been popped.
+  uint64_t front_offset_ { 0 };
+
+  // Watermarks: callbacks to run when available capacity or buffered bytes rise across a mark (0 = never)
+  uint64_t capacity_mark_ { 0 };
+  std::function<void()> capacity_callback_ {};
+  uint64_t buffered_mark_ { 0 };
+  std::function<void()> buffered_callback_ {};
+
+  // Run whichever watermark callback was crossed since the stream held `buffered_before` bytes
+  void check_watermarks( uint64_t buffered_before );
 
-  std::string buffer_ {};
+  // Ring, Mirrored and Pooled: copy `data` (no longer than available capacity) into the free space
+  void copy_in( std::string_view data );
+
+  // Pooled: borrow slabs as needed and return the next `len` bytes of free space
+  std::vector<std::span<char>> slab_free_space( uint64_t len );
+  // Pooled: return slabs that hold no buffered bytes
+  void release_slabs();
 };
 
 class Writer : public ByteStream
 {
 public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+
+  // The same, for bytes the stream can't take over (say, part of a shared buffer): they are copied once,
+  // straight into the free space (or into a chunk of their own, with Chunked storage)
+  void push_view( std::string_view data );
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  // Read from `fd` straight into the stream's free space (up to available_capacity() bytes).
+  // Returns the number of bytes read; as with FileDescriptor::read, EOF is reported by `fd.eof()`.
+  uint64_t push_from_fd( FileDescriptor& fd );
+
+  // Push up to available_capacity() bytes of `file`, starting `offset` bytes in; returns how many were pushed.
+  // Chunked storage keeps a reference to the mapped pages instead of copying them; the other storages copy
+  // straight from the mapping.
+  uint64_t push_file( const std::shared_ptr<const MappedFile>& file, uint64_t offset );
+
+  // Ring and Mirrored only: copy `data` into the free space, starting `offset` bytes past the end of the
+  // stream, without making it readable yet. commit() then publishes the next bytes of free space in place.
+  // Throws if the storage can't do this or the bytes don't fit in the available capacity.
+  void place( uint64_t offset, std::string_view data );
+  void commit( uint64_t len ); // Make the next `len` bytes of (placed) free space readable
+
+  // Call `callback` each time a pop raises available_capacity() from below `low_mark` to at least `low_mark`
+  // (clamped to the capacity), so a producer can stop when the stream fills and resume once it has drained.
+  // Replaces any earlier callback; an empty callback turns the notification off.
+  void on_capacity_above( uint64_t low_mark, std::function<void()> callback );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
@@ -47,9 +131,22 @@ public:
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
+  std::string_view peek() const; // Peek at the next contiguous bytes in the buffer
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Peek at the contiguous bytes that start `offset` bytes past the front (empty if nothing is buffered there),
+  // e.g. to read bytes that have to stay buffered until something else says they can be popped
+  std::string_view peek( uint64_t offset ) const;
+
+  // Peek at the buffered bytes as a list of at most `max_regions` contiguous regions, in order
+  // (e.g. to hand to a single writev)
+  std::vector<std::string_view> peek_iov( size_t max_regions = 16 ) const;
+
+  // Call `callback` each time a push raises bytes_buffered() from below `threshold` to at least `threshold`
+  // (clamped to the capacity), so a consumer can sleep while the stream is empty. Closing the stream does
+  // not call it; check is_finished() for that. Replaces any earlier callback; an empty callback turns it off.
+  void on_buffered_above( uint64_t threshold, std::function<void()> callback );
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
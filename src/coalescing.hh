@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Whether a segment shorter than the MSS waits for more bytes while data is in flight
+// (one that carries the last bytes of a closed stream never waits)
+enum class Coalescing : uint8_t
+{
+  Off,      // sent at once (TCP_NODELAY)
+  Nagle,    // waits until everything in flight is acked (RFC 896)
+  Autocork, // waits only until the clock moves on, so bytes pushed at the same moment share segments
+};
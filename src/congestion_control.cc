@@ -0,0 +1,281 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// RFC 6928
+uint64_t initial_window( uint64_t mss )
+{
+  return std::min( 10 * mss, std::max( 2 * mss, uint64_t { 14600 } ) );
+}
+
+// RFC 3465: in slow start, grow by the bytes acked, but by no more than two segments per ack
+uint64_t slow_start( uint64_t cwnd, uint64_t bytes_acked, uint64_t mss )
+{
+  return cwnd + std::min( bytes_acked, 2 * mss );
+}
+
+} // namespace
+
+std::unique_ptr<CongestionControl> CongestionControl::make( Algorithm algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case Algorithm::None:
+      return nullptr;
+    case Algorithm::NewReno:
+      return std::make_unique<NewReno>( mss );
+    case Algorithm::CUBIC:
+      return std::make_unique<Cubic>( mss );
+    case Algorithm::BBR:
+      return std::make_unique<BBR>( mss );
+  }
+  return nullptr;
+}
+
+NewReno::NewReno( uint64_t mss ) : CongestionControl( mss ), cwnd_( initial_window( mss ) ) {}
+
+void NewReno::on_ack( const Ack& ack )
+{
+  if ( ack.in_recovery ) {
+    return;
+  }
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ = slow_start( cwnd_, ack.bytes_acked, mss_ );
+    return;
+  }
+
+  // congestion avoidance: one segment per window of data acked
+  bytes_acked_ += ack.bytes_acked;
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_loss( uint64_t /* now */, uint64_t bytes_in_flight )
+{
+  ssthresh_ = std::max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+void NewReno::on_timeout( uint64_t /* now */, uint64_t bytes_in_flight )
+{
+  ssthresh_ = std::max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
+
+Cubic::Cubic( uint64_t mss ) : CongestionControl( mss ), cwnd_( initial_window( mss ) ) {}
+
+void Cubic::on_ack( const Ack& ack )
+{
+  if ( ack.rtt.has_value() ) {
+    min_rtt_ = std::min( min_rtt_, *ack.rtt );
+  }
+  if ( ack.in_recovery ) {
+    return;
+  }
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ = slow_start( cwnd_, ack.bytes_acked, mss_ );
+    return;
+  }
+
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  if ( !epoch_.has_value() ) {
+    epoch_ = ack.now;
+    if ( cwnd < w_max_ ) {
+      k_ = std::cbrt( ( w_max_ - cwnd ) / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd;
+    }
+    w_est_ = cwnd;
+  }
+
+  // where the curve will be one RTT from now, but no more than 1.5 times the current window
+  const double rtt = min_rtt_ == UINT64_MAX ? 0 : static_cast<double>( min_rtt_ ) / 1e6;
+  const double t = static_cast<double>( ack.now - *epoch_ ) / 1e6 + rtt;
+  const double target = std::clamp( C * std::pow( t - k_, 3 ) + w_max_, cwnd, 1.5 * cwnd );
+
+  const double acked = static_cast<double>( ack.bytes_acked ) / static_cast<double>( mss_ );
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * acked / cwnd;
+
+  // never slower than Reno would be
+  const double next = std::max( cwnd + ( target - cwnd ) / cwnd * acked, w_est_ );
+  cwnd_ = std::max( cwnd_, static_cast<uint64_t>( next * static_cast<double>( mss_ ) ) );
+}
+
+void Cubic::reduce()
+{
+  // fast convergence: if the last loss came sooner than the one before, give up some more room
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  w_max_ = cwnd < w_max_ ? cwnd * ( 1 + BETA ) / 2 : cwnd;
+  ssthresh_ = std::max( static_cast<uint64_t>( std::round( static_cast<double>( cwnd_ ) * BETA ) ), 2 * mss_ );
+  epoch_.reset();
+}
+
+void Cubic::on_loss( uint64_t /* now */, uint64_t /* bytes_in_flight */ )
+{
+  reduce();
+  cwnd_ = ssthresh_;
+}
+
+void Cubic::on_timeout( uint64_t /* now */, uint64_t /* bytes_in_flight */ )
+{
+  reduce();
+  cwnd_ = mss_;
+}
+
+BBR::BBR( uint64_t mss ) : CongestionControl( mss ), cwnd_( initial_window( mss ) ) {}
+
+uint64_t BBR::bandwidth() const
+{
+  return *std::max_element( bandwidth_samples_.begin(), bandwidth_samples_.end() );
+}
+
+uint64_t BBR::bdp() const
+{
+  if ( bandwidth() == 0 || min_rtt_ == UINT64_MAX ) {
+    return initial_window( mss_ );
+  }
+  return bandwidth() * min_rtt_ / 1'000'000;
+}
+
+double BBR::pacing_gain() const
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+      return HIGH_GAIN;
+    case Mode::Drain:
+      return 1 / HIGH_GAIN;
+    case Mode::ProbeBW:
+      return PROBE_BW_GAINS.at( cycle_index_ );
+    case Mode::ProbeRTT:
+      return 1;
+  }
+  return 1;
+}
+
+double BBR::cwnd_gain() const
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+    case Mode::Drain:
+      return HIGH_GAIN;
+    case Mode::ProbeBW:
+      return 2;
+    case Mode::ProbeRTT:
+      return 1;
+  }
+  return 1;
+}
+
+void BBR::on_ack( const Ack& ack )
+{
+  // a round trip ends when data sent after it began is delivered
+  bool round_start = false;
+  if ( ack.prior_delivered >= next_round_delivered_ ) {
+    next_round_delivered_ = ack.delivered;
+    ++round_;
+    round_start = true;
+    bandwidth_samples_.at( round_ % BANDWIDTH_WINDOW ) = 0;
+  }
+
+  update_model( ack );
+  update_mode( ack, round_start );
+
+  if ( bandwidth() > 0 ) {
+    pacing_rate_ = static_cast<uint64_t>( pacing_gain() * static_cast<double>( bandwidth() ) );
+  }
+
+  if ( mode_ == Mode::ProbeRTT ) {
+    cwnd_ = 4 * mss_;
+    return;
+  }
+  const uint64_t target
+    = std::max( static_cast<uint64_t>( cwnd_gain() * static_cast<double>( bdp() ) ), 4 * mss_ );
+  if ( filled_pipe_ ) {
+    cwnd_ = std::min( cwnd_ + ack.bytes_acked, target );
+  } else if ( cwnd_ < target || ack.delivered < initial_window( mss_ ) ) {
+    cwnd_ += ack.bytes_acked;
+  }
+  cwnd_ = std::max( cwnd_, 4 * mss_ );
+}
+
+void BBR::update_model( const Ack& ack )
+{
+  if ( ack.delivery_rate.has_value() ) {
+    auto& sample = bandwidth_samples_.at( round_ % BANDWIDTH_WINDOW );
+    sample = std::max( sample, *ack.delivery_rate );
+  }
+
+  min_rtt_expired_ = ack.now > min_rtt_stamp_ + MIN_RTT_WINDOW;
+  if ( ack.rtt.has_value() && ( *ack.rtt <= min_rtt_ || min_rtt_expired_ ) ) {
+    min_rtt_ = *ack.rtt;
+    min_rtt_stamp_ = ack.now;
+  }
+}
+
+void BBR::update_mode( const Ack& ack, bool round_start )
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+      // the pipe is full once three rounds in a row fail to grow the bandwidth by a quarter
+      if ( round_start ) {
+        if ( bandwidth() >= full_bandwidth_ + full_bandwidth_ / 4 ) {
+          full_bandwidth_ = bandwidth();
+          full_bandwidth_rounds_ = 0;
+        } else if ( ++full_bandwidth_rounds_ >= 3 ) {
+          filled_pipe_ = true;
+          mode_ = Mode::Drain;
+        }
+      }
+      break;
+
+    case Mode::Drain:
+      if ( ack.bytes_in_flight <= bdp() ) {
+        mode_ = Mode::ProbeBW;
+        cycle_index_ = 0;
+        cycle_stamp_ = ack.now;
+      }
+      break;
+
+    case Mode::ProbeBW:
+      if ( min_rtt_ != UINT64_MAX && ack.now - cycle_stamp_ > min_rtt_ ) {
+        cycle_index_ = ( cycle_index_ + 1 ) % PROBE_BW_GAINS.size();
+        cycle_stamp_ = ack.now;
+      }
+      break;
+
+    case Mode::ProbeRTT:
+      if ( !probe_rtt_done_.has_value() && ack.bytes_in_flight <= 4 * mss_ ) {
+        probe_rtt_done_ = ack.now + PROBE_RTT_DURATION;
+      } else if ( probe_rtt_done_.has_value() && ack.now >= *probe_rtt_done_ ) {
+        min_rtt_stamp_ = ack.now;
+        mode_ = filled_pipe_ ? Mode::ProbeBW : Mode::Startup;
+        cycle_stamp_ = ack.now;
+      }
+      break;
+  }
+
+  if ( min_rtt_expired_ && mode_ != Mode::ProbeRTT ) {
+    mode_ = Mode::ProbeRTT;
+    probe_rtt_done_.reset();
+  }
+}
+
+void BBR::on_loss( uint64_t /* now */, uint64_t /* bytes_in_flight */ )
+{
+  // the model, not loss, sets the window
+}
+
+void BBR::on_timeout( uint64_t /* now */, uint64_t /* bytes_in_flight */ )
+{
+  // start over from one segment; acks grow the window back toward the model's
+  cwnd_ = mss_;
+}
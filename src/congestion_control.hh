@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+/*
+ * A congestion controller decides how many bytes the TCPSender may have in flight (the congestion
+ * window) and how fast it should send them (the pacing rate), from the events the sender reports.
+ *
+ * Times are in microseconds on the sender's clock; sizes are in bytes.
+ */
+class CongestionControl
+{
+public:
+  enum class Algorithm : uint8_t
+  {
+    None,    // No congestion window: only the receiver's window limits the sender
+    NewReno, // RFC 5681 and RFC 6582
+    CUBIC,   // RFC 9438
+    BBR,     // A model-based controller after BBR (bottleneck bandwidth and round-trip propagation time)
+  };
+
+  // Returns nullptr for Algorithm::None
+  static std::unique_ptr<CongestionControl> make( Algorithm algorithm, uint64_t mss );
+
+  // An ack that delivered new data (acked cumulatively or SACKed)
+  struct Ack
+  {
+    uint64_t now {};
+    uint64_t bytes_acked {};                  // newly delivered by this ack
+    uint64_t bytes_in_flight {};              // in the pipe after it (RFC 6675)
+    bool in_recovery {};                      // the sender is still repairing a loss
+    std::optional<uint64_t> rtt {};           // from a segment that was sent only once (Karn's rule)
+    uint64_t delivered {};                    // bytes delivered over the connection so far
+    uint64_t prior_delivered {};              // ... when the newest segment this ack delivered was sent
+    std::optional<uint64_t> delivery_rate {}; // bytes per second, over that segment's flight
+  };
+
+  virtual void on_ack( const Ack& ack ) = 0;
+
+  // Loss detected from SACK blocks or duplicate acks: called once per window of data
+  virtual void on_loss( uint64_t now, uint64_t bytes_in_flight ) = 0;
+
+  // The retransmission timer expired
+  virtual void on_timeout( uint64_t now, uint64_t bytes_in_flight ) = 0;
+
+  // The receiver echoed a congestion-experienced mark: called once per window of data
+  virtual void on_ecn( uint64_t now, uint64_t bytes_in_flight ) = 0;
+
+  virtual uint64_t cwnd() const = 0;
+  virtual uint64_t pacing_rate() const = 0; // bytes per second (0 if the controller doesn't pace)
+  virtual std::string_view name() const = 0;
+
+  // The sender's segment size changed (negotiated with the peer, or raised by path MTU discovery):
+  // the window grows and shrinks by segments of the new size from now on
+  void set_mss( uint64_t mss ) { mss_ = mss; }
+  uint64_t mss() const { return mss_; }
+
+  virtual ~CongestionControl() = default;
+
+protected:
+  explicit CongestionControl( uint64_t mss ) : mss_( mss ) {}
+
+  uint64_t mss_; // NOLINT(*-non-private-member-variables-in-classes)
+};
+
+// Slow start, then one segment more per window of data acked; halve on loss
+class NewReno : public CongestionControl
+{
+public:
+  explicit NewReno( uint64_t mss );
+
+  void on_ack( const Ack& ack ) override;
+  void on_loss( uint64_t now, uint64_t bytes_in_flight ) override;
+  void on_timeout( uint64_t now, uint64_t bytes_in_flight ) override;
+  void on_ecn( uint64_t now, uint64_t bytes_in_flight ) override { on_loss( now, bytes_in_flight ); }
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t pacing_rate() const override { return 0; }
+  std::string_view name() const override { return "newreno"; }
+
+  uint64_t ssthresh() const { return ssthresh_; }
+
+private:
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ { 0 }; // toward the next increase in congestion avoidance
+};
+
+// After a loss, grow back toward the window where the loss happened along a cubic curve: quickly at
+// first, slowly near it, then quickly again past it
+class Cubic : public CongestionControl
+{
+public:
+  explicit Cubic( uint64_t mss );
+
+  void on_ack( const Ack& ack ) override;
+  void on_loss( uint64_t now, uint64_t bytes_in_flight ) override;
+  void on_timeout( uint64_t now, uint64_t bytes_in_flight ) override;
+  void on_ecn( uint64_t now, uint64_t bytes_in_flight ) override { on_loss( now, bytes_in_flight ); }
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t pacing_rate() const override { return 0; }
+  std::string_view name() const override { return "cubic"; }
+
+  uint64_t ssthresh() const { return ssthresh_; }
+
+  static constexpr double C = 0.4;    // segments per second cubed
+  static constexpr double BETA = 0.7; // window kept on a loss
+
+private:
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+
+  double w_max_ { 0 };               // window before the last reduction, in segments
+  double w_est_ { 0 };               // what Reno would have by now, in segments
+  double k_ { 0 };                   // seconds from the epoch start until the curve gets back to w_max_
+  std::optional<uint64_t> epoch_ {}; // when the current congestion-avoidance epoch started
+  uint64_t min_rtt_ { UINT64_MAX };
+
+  void reduce();
+};
+
+// Estimate the path's bottleneck bandwidth and round-trip propagation time, then pace at that
+// bandwidth and keep about one bandwidth-delay product in flight, probing periodically for more
+// bandwidth (and less delay). Loss is not taken as a congestion signal, except after a timeout.
+class BBR : public CongestionControl
+{
+public:
+  explicit BBR( uint64_t mss );
+
+  void on_ack( const Ack& ack ) override;
+  void on_loss( uint64_t now, uint64_t bytes_in_flight ) override;
+  void on_timeout( uint64_t now, uint64_t bytes_in_flight ) override;
+  void on_ecn( uint64_t /* now */, uint64_t /* bytes_in_flight */ ) override {}
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t pacing_rate() const override { return pacing_rate_; }
+  std::string_view name() const override { return "bbr"; }
+
+  enum class Mode : uint8_t
+  {
+    Startup,  // double the sending rate every round trip until the bandwidth stops growing
+    Drain,    // drain the queue that Startup built
+    ProbeBW,  // cycle the pacing gain around 1 to probe for more bandwidth
+    ProbeRTT, // briefly shrink the window to remeasure the propagation delay
+  };
+  Mode mode() const { return mode_; }
+  uint64_t bandwidth() const; // bytes per second: the largest delivery rate over the last rounds
+  uint64_t min_rtt() const { return min_rtt_; }
+
+private:
+  static constexpr double HIGH_GAIN = 2.885; // 2/ln(2)
+  static constexpr std::array<double, 8> PROBE_BW_GAINS { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+  static constexpr uint64_t BANDWIDTH_WINDOW = 10;        // rounds
+  static constexpr uint64_t MIN_RTT_WINDOW = 10'000'000;  // microseconds
+  static constexpr uint64_t PROBE_RTT_DURATION = 200'000; // microseconds
+
+  uint64_t cwnd_;
+  uint64_t pacing_rate_ { 0 };
+  Mode mode_ { Mode::Startup };
+
+  // Rounds: a round ends when data sent after it began is delivered
+  uint64_t round_ { 0 };
+  uint64_t next_round_delivered_ { 0 };
+
+  // Windowed max of the delivery rate: the best sample in each of the last rounds
+  std::array<uint64_t, BANDWIDTH_WINDOW> bandwidth_samples_ {};
+
+  uint64_t min_rtt_ { UINT64_MAX };
+  uint64_t min_rtt_stamp_ { 0 };
+  bool min_rtt_expired_ { false }; // not remeasured for MIN_RTT_WINDOW
+
+  // Startup: has the bandwidth stopped growing?
+  uint64_t full_bandwidth_ { 0 };
+  uint64_t full_bandwidth_rounds_ { 0 };
+  bool filled_pipe_ { false };
+
+  size_t cycle_index_ { 0 };
+  uint64_t cycle_stamp_ { 0 };
+  std::optional<uint64_t> probe_rtt_done_ {};
+
+  double pacing_gain() const;
+  double cwnd_gain() const;
+  uint64_t bdp() const;
+  void update_model( const Ack& ack );
+  void update_mode( const Ack& ack, bool round_start );
+};
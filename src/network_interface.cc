@@ -11,11 +11,13 @@ using namespace std;
 NetworkInterface::NetworkInterface( string_view name,
                                     shared_ptr<OutputPort> port,
                                     const EthernetAddress& ethernet_address,
-                                    const Address& ip_address )
+                                    const Address& ip_address,
+                                    size_t mtu )
   : name_( name )
   , port_( notnull( "OutputPort", move( port ) ) )
   , ethernet_address_( ethernet_address )
   , ip_address_( ip_address )
+  , mtu_( mtu )
 {
   cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address )
        << " and IP address " << ip_address.ip() << "\n";
@@ -33,7 +35,7 @@ EthernetFrame NetworkInterface::encapsulate( const std::vector<std::string>& pay
 
   EthernetFrame frame {
     .header = std::move( header ),
-    .payload = payload,
+    .payload = to_slices( payload ),
   };
 
   return frame;
@@ -58,6 +60,9 @@ void NetworkInterface::send_arp_message( const IPv4Address& dest_ip,
 
 void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
 {
+  if ( dgram.header.len > mtu_ )
+    return;
+
   IPv4Address dst_ip = next_hop.ipv4_numeric();
   if ( arp_table_.contains( dst_ip ) ) {
     EthernetFrame ipv4_frame
@@ -62,17 +62,24 @@ public:
     virtual ~OutputPort() = default;
   };
 
+  // Largest IP datagram a standard Ethernet frame carries
+  static constexpr size_t DEFAULT_MTU = 1500;
+
   // Construct a network interface with given Ethernet (network-access-layer) and IP
-  // (internet-layer) addresses
+  // (internet-layer) addresses, on a link that carries datagrams of up to `mtu` bytes
+  // (up to 9000 with jumbo frames)
   NetworkInterface( std::string_view name,
                     std::shared_ptr<OutputPort> port,
                     const EthernetAddress& ethernet_address,
-                    const Address& ip_address );
+                    const Address& ip_address,
+                    size_t mtu = DEFAULT_MTU );
 
   // Sends an Internet datagram, encapsulated in an Ethernet frame (if it knows the
   // Ethernet destination address). Will need to use [ARP](\ref rfc::rfc826) to look up
   // the Ethernet destination address for the next hop. Sending is accomplished by calling
-  // `transmit()` (a member variable) on the frame.
+  // `transmit()` (a member variable) on the frame. A datagram larger than the MTU is
+  // dropped: there's no fragmentation, and no ICMP error either (as on a path that blocks
+  // them), so the sender has to find the path MTU on its own.
   void send_datagram( const InternetDatagram& dgram, const Address& next_hop );
 
   // Receives an Ethernet frame and responds appropriately.
@@ -86,6 +93,7 @@ public:
 
   // Accessors
   const std::string& name() const { return name_; }
+  size_t mtu() const { return mtu_; }
   const OutputPort& output() const { return *port_; }
   OutputPort& output() { return *port_; }
   std::queue<InternetDatagram>& datagrams_received() { return datagrams_received_; }
@@ -106,6 +114,9 @@ private:
   // IP (known as internet-layer or network-layer) address of the interface
   Address ip_address_;
 
+  // Largest IP datagram the link carries
+  size_t mtu_;
+
   // Datagrams that have been received
   std::queue<InternetDatagram> datagrams_received_ {};
 
@@ -1,11 +1,140 @@
 #include "reassembler.hh"
 
-void Reassembler::insert( uint64_t first_index, std::string data, bool is_last_substring )
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+Reassembler::Reassembler( ByteStream&& output, Placement placement, std::shared_ptr<ReassemblyBudget> budget )
+  : output_( std::move( output ) ), placement_( placement ), budget_( std::move( budget ) )
+{
+  if ( placement_ == Placement::Direct ) {
+    if ( output_.storage() != ByteStream::Storage::Ring && output_.storage() != ByteStream::Storage::Mirrored ) {
+      placement_ = Placement::Buffered;
+    } else {
+      const uint64_t capacity = output_.writer().available_capacity() + output_.reader().bytes_buffered();
+      present_.resize( ( capacity + 63 ) / 64 );
+      present_bits_ = present_.size() * 64;
+      budget_.reset();
+    }
+  }
+
+  if ( budget_ ) {
+    budget_->members_.push_back( this );
+  }
+}
+
+Reassembler::Reassembler( const Reassembler& other )
+  : output_( other.output_ )
+  , index_( other.index_ )
+  , pending_( other.pending_ )
+  , last_index_( other.last_index_ )
+  , received_last_( other.received_last_ )
+  , buffer_( other.buffer_ )
+  , ranges_( other.ranges_ )
+  , placement_( other.placement_ )
+  , present_( other.present_ )
+  , present_bits_( other.present_bits_ )
+  , recent_inserts_( other.recent_inserts_ )
+  , counters_( other.counters_ )
+  , gap_opened_at_( other.gap_opened_at_ )
+  , budget_( other.budget_ )
+{
+  if ( budget_ ) {
+    budget_->members_.push_back( this );
+    budget_->in_use_ += pending_;
+  }
+}
+
+Reassembler::Reassembler( Reassembler&& other ) noexcept
+  : output_( std::move( other.output_ ) )
+  , index_( other.index_ )
+  , pending_( other.pending_ )
+  , last_index_( other.last_index_ )
+  , received_last_( other.received_last_ )
+  , buffer_( std::move( other.buffer_ ) )
+  , ranges_( std::move( other.ranges_ ) )
+  , placement_( other.placement_ )
+  , present_( std::move( other.present_ ) )
+  , present_bits_( other.present_bits_ )
+  , recent_inserts_( std::move( other.recent_inserts_ ) )
+  , counters_( other.counters_ )
+  , gap_opened_at_( other.gap_opened_at_ )
+  , budget_( std::move( other.budget_ ) )
+{
+  other.pending_ = 0;
+  if ( budget_ ) {
+    std::replace( budget_->members_.begin(), budget_->members_.end(), &other, this );
+  }
+}
+
+Reassembler::~Reassembler()
+{
+  if ( budget_ ) {
+    std::erase( budget_->members_, this );
+    budget_->in_use_ -= pending_;
+  }
+}
+
+bool ReassemblyBudget::charge( Reassembler& charger, uint64_t distance, uint64_t bytes )
+{
+  while ( in_use_ + bytes > limit_ ) {
+    Reassembler* furthest = nullptr;
+    for ( auto* member : members_ ) {
+      if ( member->furthest_pending() > ( furthest ? furthest->furthest_pending() : 0 ) ) {
+        furthest = member;
+      }
+    }
+
+    ++evictions_;
+    if ( furthest == nullptr || furthest->furthest_pending() <= distance ) {
+      ++charger.counters_.evictions;
+      return false;
+    }
+    furthest->evict_furthest();
+  }
+
+  in_use_ += bytes;
+  return true;
+}
+
+uint64_t Reassembler::furthest_pending() const
+{
+  return buffer_.empty() ? 0 : buffer_.rbegin()->first.second - index_;
+}
+
+void Reassembler::evict_furthest()
+{
+  const auto last = std::prev( buffer_.end() );
+  release( last->second.size() );
+  remove_range( last->first );
+  buffer_.erase( last );
+  ++counters_.evictions;
+}
+
+void Reassembler::release( uint64_t bytes )
+{
+  pending_ -= bytes;
+  if ( budget_ ) {
+    budget_->in_use_ -= bytes;
+  }
+}
+
+void Reassembler::insert( uint64_t first_index, BufferSlice data, bool is_last_substring )
 {
   scope avaliable_scope
     = std::make_pair( index_, index_ + output_.writer().available_capacity() );
   scope data_scope = std::make_pair( first_index, first_index + data.size() );
 
+  const uint64_t pending_before = pending_;
+  const uint64_t merges_before = counters_.merges;
+  ++counters_.inserts;
+  if ( data_scope.first < avaliable_scope.first ) {
+    counters_.duplicate_bytes += std::min( data_scope.second, avaliable_scope.first ) - data_scope.first;
+  }
+  if ( data_scope.second > avaliable_scope.second ) {
+    counters_.beyond_capacity_bytes += data_scope.second - std::max( data_scope.first, avaliable_scope.second );
+  }
+
   if ( is_last_substring && !received_last_ ) {
     last_index_ = data_scope.second;
     received_last_ = true;
@@ -16,60 +145,105 @@ void Reassembler::insert( uint64_t first_index, std::string data, bool is_last_s
     goto check_close;
   }
 
+  note_recent_insert( std::max( data_scope.first, avaliable_scope.first ) );
+
+  if ( placement_ == Placement::Direct ) {
+    const uint64_t first = std::max( data_scope.first, avaliable_scope.first );
+    const uint64_t last = std::min( data_scope.second, avaliable_scope.second );
+    place( first, std::string_view( data ).substr( first - data_scope.first, last - first ) );
+    goto check_close;
+  }
+
   // truncate data to fit in available scope
   if ( data_scope.second > avaliable_scope.second ) {
-    data.erase( avaliable_scope.second - data_scope.first );
+    data.remove_suffix( data_scope.second - avaliable_scope.second );
     data_scope.second = avaliable_scope.second;
   }
   if ( data_scope.first < avaliable_scope.first ) {
-    data.erase( 0, avaliable_scope.first - data_scope.first );
+    data.remove_prefix( avaliable_scope.first - data_scope.first );
     data_scope.first = avaliable_scope.first;
   }
 
-  for ( auto it = buffer_.begin(); it != buffer_.end(); ) {
-    const auto& item = *it;
-    const auto& item_scope = item.first;
-    const auto& item_data = item.second;
-    // check if data and item are disjoint
-    if ( data_scope.first > item_scope.second || data_scope.second < item_scope.first ) {
-      ++it;
-      continue;
+  if ( data_scope.first == index_
+       && ( buffer_.empty() || data_scope.second <= buffer_.begin()->first.first ) ) {
+    // fast path: in-order data that overlaps nothing pending goes straight to the output
+    output_.writer().push_view( data );
+    index_ = data_scope.second;
+  } else {
+    // Pending segments are disjoint, so they are sorted by both ends: the first one that can overlap
+    // the data is the last one starting at or before it, or else the next one. Bytes that are already
+    // pending are kept and cut from the new data, so nothing pending is copied again.
+    auto it = buffer_.lower_bound( std::make_pair( data_scope.first, uint64_t { 0 } ) );
+    if ( it != buffer_.begin() && std::prev( it )->first.second > data_scope.first ) {
+      --it;
     }
-    // merge data with item
-    std::string merged_data {};
-    if ( item_scope.first < data_scope.first ) {
-      merged_data = std::move( item_data );
-      if ( item_scope.second < data_scope.second ) {
-        merged_data.append( data,
-                            item_scope.second - data_scope.first,
-                            data_scope.second - item_scope.second );
+
+    while ( it != buffer_.end() && it->first.first < data_scope.second ) {
+      const scope item_scope = it->first;
+      if ( item_scope.first <= data_scope.first && item_scope.second >= data_scope.second ) {
+        counters_.duplicate_bytes += data.size();
+        goto check_close; // nothing new
       }
-    } else {
-      merged_data = std::move( data );
-      if ( item_scope.second > data_scope.second ) {
-        merged_data.append( item_data,
-                            data_scope.second - item_scope.first,
-                            item_scope.second - data_scope.second );
+      if ( item_scope.first < data_scope.first ) {
+        counters_.duplicate_bytes += item_scope.second - data_scope.first;
+        data.remove_prefix( item_scope.second - data_scope.first );
+        data_scope.first = item_scope.second;
+        ++it;
+      } else if ( item_scope.second > data_scope.second ) {
+        counters_.duplicate_bytes += data_scope.second - item_scope.first;
+        data.remove_suffix( data_scope.second - item_scope.first );
+        data_scope.second = item_scope.first;
+        break;
+      } else {
+        counters_.duplicate_bytes += item_scope.second - item_scope.first;
+        release( item_scope.second - item_scope.first );
+        remove_range( item_scope );
+        it = buffer_.erase( it ); // the new data covers it
       }
     }
-    data = std::move( merged_data );
-    data_scope.first = std::min( item_scope.first, data_scope.first );
-    data_scope.second = std::max( item_scope.second, data_scope.second );
 
-    pending_ -= item_scope.second - item_scope.first;
-    it = buffer_.erase( it ); // Erase and move to the next element
+    if ( data.empty() ) {
+      goto check_close;
+    }
+    if ( data_scope.first == index_ ) {
+      output_.writer().push_view( data );
+      index_ = data_scope.second;
+    } else {
+      if ( budget_ && !budget_->charge( *this, data_scope.second - index_, data.size() ) ) {
+        goto check_close;
+      }
+      pending_ += data.size();
+      add_range( data_scope );
+      data.shrink_to_fit(); // don't let a short segment pin the whole buffer it was read into
+      buffer_.emplace( data_scope, std::move( data ) );
+    }
   }
 
-  // write data
-  if ( data_scope.first == index_ ) {
-    output_.writer().push( std::move( data ) );
-    index_ = data_scope.second;
-  } else {
-    pending_ += data.size();
-    buffer_.insert( std::make_pair( data_scope, std::move( data ) ) );
+  // write the pending segments that now continue the stream
+  if ( !buffer_.empty() && buffer_.begin()->first.first == index_ ) {
+    ++counters_.merges;
+  }
+  while ( !buffer_.empty() && buffer_.begin()->first.first == index_ ) {
+    auto node = buffer_.extract( buffer_.begin() );
+    release( node.mapped().size() );
+    remove_range( node.key() );
+    index_ = node.key().second;
+    output_.writer().push_view( node.mapped() );
   }
 
 check_close:
+  counters_.peak_bytes_pending = std::max( counters_.peak_bytes_pending, pending_ );
+  counters_.peak_pending_segments = std::max<uint64_t>( counters_.peak_pending_segments, buffer_.size() );
+  if ( counters_.merges != merges_before ) {
+    const uint64_t fill_inserts = counters_.inserts - gap_opened_at_;
+    ++counters_.holes_filled;
+    counters_.fill_inserts_total += fill_inserts;
+    counters_.fill_inserts_max = std::max( counters_.fill_inserts_max, fill_inserts );
+    gap_opened_at_ = counters_.inserts; // if bytes are still pending, the next gap is open from here
+  } else if ( pending_before == 0 && pending_ > 0 ) {
+    gap_opened_at_ = counters_.inserts;
+  }
+
   if ( received_last_ && index_ == last_index_ ) {
     output_.writer().close();
   }
@@ -79,3 +253,180 @@ uint64_t Reassembler::bytes_pending() const
 {
   return pending_;
 }
+
+void Reassembler::place( uint64_t first_index, std::string_view data )
+{
+  Writer& writer = output_.writer();
+
+  // fast path: in-order data with nothing pending
+  if ( first_index == index_ && pending_ == 0 ) {
+    writer.place( 0, data );
+    writer.commit( data.size() );
+    index_ += data.size();
+    return;
+  }
+
+  writer.place( first_index - index_, data );
+  const uint64_t newly_present = mark_present( first_index, first_index + data.size() );
+  pending_ += newly_present;
+  counters_.duplicate_bytes += data.size() - newly_present;
+
+  const uint64_t run = present_run( index_ );
+  if ( run == 0 ) {
+    return;
+  }
+  if ( run > ( first_index == index_ ? data.size() : 0 ) ) {
+    ++counters_.merges;
+  }
+
+  // clear the run's bits, then publish the bytes where they already are
+  for ( uint64_t i = index_; i < index_ + run; ) {
+    const uint64_t bit = i % present_bits_;
+    const uint64_t len = std::min( index_ + run - i, 64 - bit % 64 );
+    present_[bit / 64] &= ~( ( len == 64 ? ~uint64_t { 0 } : ( uint64_t { 1 } << len ) - 1 ) << ( bit % 64 ) );
+    i += len;
+  }
+  pending_ -= run;
+  index_ += run;
+  writer.commit( run );
+}
+
+uint64_t Reassembler::mark_present( uint64_t first_index, uint64_t last_index )
+{
+  uint64_t newly_set = 0;
+  while ( first_index < last_index ) {
+    const uint64_t bit = first_index % present_bits_;
+    const uint64_t len = std::min( last_index - first_index, 64 - bit % 64 );
+    const uint64_t mask = ( len == 64 ? ~uint64_t { 0 } : ( uint64_t { 1 } << len ) - 1 ) << ( bit % 64 );
+    uint64_t& word = present_[bit / 64];
+    newly_set += std::popcount( mask & ~word );
+    word |= mask;
+    first_index += len;
+  }
+  return newly_set;
+}
+
+uint64_t Reassembler::present_run( uint64_t from ) const
+{
+  const uint64_t window_end = index_ + output_.writer().available_capacity();
+  const uint64_t window = window_end > from ? window_end - from : 0;
+  uint64_t run = 0;
+  while ( run < window ) {
+    const uint64_t bit = ( from + run ) % present_bits_;
+    const uint64_t ones = std::countr_one( present_[bit / 64] >> ( bit % 64 ) );
+    run += ones;
+    if ( ones < 64 - bit % 64 ) {
+      break;
+    }
+  }
+  return std::min( run, window );
+}
+
+uint64_t Reassembler::present_run_before( uint64_t to ) const
+{
+  const uint64_t window = to - index_;
+  uint64_t run = 0;
+  while ( run < window ) {
+    const uint64_t bit = ( to - run - 1 ) % present_bits_;
+    const uint64_t ones = std::countl_one( present_[bit / 64] << ( 63 - bit % 64 ) );
+    run += ones;
+    if ( ones < bit % 64 + 1 ) {
+      break;
+    }
+  }
+  return std::min( run, window );
+}
+
+void Reassembler::add_range( scope range )
+{
+  auto next = ranges_.lower_bound( range.first );
+  if ( next != ranges_.end() && next->first == range.second ) {
+    range.second = next->second;
+    next = ranges_.erase( next );
+  }
+  if ( next != ranges_.begin() && std::prev( next )->second == range.first ) {
+    std::prev( next )->second = range.second;
+  } else {
+    ranges_.emplace_hint( next, range );
+  }
+}
+
+void Reassembler::remove_range( scope range )
+{
+  const auto it = std::prev( ranges_.upper_bound( range.first ) );
+  const scope whole = *it;
+  ranges_.erase( it );
+  if ( whole.first < range.first ) {
+    ranges_.emplace( whole.first, range.first );
+  }
+  if ( range.second < whole.second ) {
+    ranges_.emplace( range.second, whole.second );
+  }
+}
+
+void Reassembler::note_recent_insert( uint64_t first_index )
+{
+  std::erase_if( recent_inserts_, [&]( uint64_t i ) { return i < index_ || i == first_index; } );
+  recent_inserts_.insert( recent_inserts_.begin(), first_index );
+  if ( recent_inserts_.size() > max_recent_inserts ) {
+    recent_inserts_.pop_back();
+  }
+}
+
+std::optional<Reassembler::scope> Reassembler::interval_around( uint64_t index ) const
+{
+  if ( placement_ == Placement::Direct ) {
+    if ( index < index_ || present_run( index ) == 0 ) {
+      return std::nullopt;
+    }
+    return scope { index - present_run_before( index ), index + present_run( index ) };
+  }
+
+  const auto it = ranges_.upper_bound( index );
+  if ( it == ranges_.begin() || std::prev( it )->second <= index ) {
+    return std::nullopt;
+  }
+  return scope( *std::prev( it ) );
+}
+
+Reassembler::scope Reassembler::next_interval( uint64_t from ) const
+{
+  if ( placement_ == Placement::Direct ) {
+    // skip the bytes that haven't arrived, a word at a time
+    const uint64_t window_end = index_ + output_.writer().available_capacity();
+    while ( from < window_end ) {
+      const uint64_t bit = from % present_bits_;
+      const uint64_t zeros = std::countr_zero( present_[bit / 64] >> ( bit % 64 ) );
+      if ( zeros < 64 - bit % 64 ) {
+        from += zeros;
+        break;
+      }
+      from += 64 - bit % 64;
+    }
+    return from < window_end ? scope { from, from + present_run( from ) } : scope { from, from };
+  }
+
+  const auto it = ranges_.lower_bound( from );
+  return it == ranges_.end() ? scope { from, from } : scope( *it );
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> Reassembler::pending_intervals( size_t max_intervals ) const
+{
+  std::vector<scope> ret;
+  const auto add = [&]( const scope& range ) {
+    if ( ret.size() < max_intervals && std::find( ret.begin(), ret.end(), range ) == ret.end() ) {
+      ret.push_back( range );
+    }
+  };
+
+  for ( const uint64_t first_index : recent_inserts_ ) {
+    if ( const auto range = interval_around( first_index ) ) {
+      add( *range );
+    }
+  }
+  for ( scope range = next_interval( index_ ); range.first < range.second && ret.size() < max_intervals;
+        range = next_interval( range.second ) ) {
+    add( range );
+  }
+  return ret;
+}
@@ -1,19 +1,95 @@
 #pragma once
 
+#include "buffer_slice.hh"
 #include "byte_stream.hh"
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+
+class Reassembler;
+
+// A limit on the out-of-order bytes held by a group of Reassemblers (say, all of a host's connections).
+// When a Reassembler would go over it, the pending segments that lie furthest past their own stream's
+// next index are evicted first, across the whole group, since they are the cheapest for a sender to
+// resend; if the new segment is further out than all of them, it is dropped instead. Not thread-safe:
+// every Reassembler in the group must be used from the same thread.
+class ReassemblyBudget
+{
+public:
+  explicit ReassemblyBudget( uint64_t limit ) : limit_( limit ) {}
+
+  uint64_t limit() const { return limit_; }
+  uint64_t in_use() const { return in_use_; }       // Out-of-order bytes held by the group
+  uint64_t evictions() const { return evictions_; } // Segments evicted or dropped, across the group
+
+private:
+  friend class Reassembler;
+
+  uint64_t limit_;
+  uint64_t in_use_ { 0 };
+  uint64_t evictions_ { 0 };
+  std::vector<Reassembler*> members_ {};
+
+  // Make room for `bytes` that end `distance` bytes past `charger`'s next index, evicting as needed.
+  // Returns false if the bytes should be dropped instead.
+  bool charge( Reassembler& charger, uint64_t distance, uint64_t bytes );
+};
 
 class Reassembler
 {
 public:
+  // Where out-of-order bytes wait for the gaps before them to fill
+  enum class Placement : uint8_t
+  {
+    Buffered, // In a map of pending segments, pushed to the stream once they are in order
+    Direct,   // Copied straight to their final place in the stream's free space; a bitset tracks which
+              // bytes have arrived. Needs Ring or Mirrored storage.
+  };
+
   // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ) {}
+  // Direct placement falls back to Buffered when the stream's storage can't support it.
+  // A Buffered Reassembler charges its pending bytes to `budget`, if given; a Direct one keeps them in the
+  // stream's own memory and doesn't.
+  explicit Reassembler( ByteStream&& output,
+                        Placement placement = Placement::Buffered,
+                        std::shared_ptr<ReassemblyBudget> budget = {} );
+
+  // Copies charge the budget too; a Reassembler can't be reassigned
+  Reassembler( const Reassembler& other );
+  Reassembler( Reassembler&& other ) noexcept;
+  Reassembler& operator=( const Reassembler& other ) = delete;
+  Reassembler& operator=( Reassembler&& other ) = delete;
+  ~Reassembler();
+
+  Placement placement() const { return placement_; } // Which placement the Reassembler actually uses
+
+  // Cheap counters, to tell reordering from duplication
+  struct Counters
+  {
+    uint64_t inserts {};               // calls to insert()
+    uint64_t duplicate_bytes {};       // bytes dropped because they were already written or pending
+    uint64_t beyond_capacity_bytes {}; // bytes dropped because they lay past the available capacity
+    uint64_t evictions {};             // pending segments evicted (or new ones dropped) to stay within the budget
+    uint64_t merges {};                // inserts that filled a gap and wrote pending bytes out behind it
+    uint64_t peak_pending_segments {}; // most segments pending at once (Buffered placement only)
+    uint64_t peak_bytes_pending {};    // most bytes pending at once
+    uint64_t holes_filled {};          // gaps that filled while bytes after them were pending
+    uint64_t fill_inserts_total {};    // inserts from a gap opening to its filling, summed over holes_filled
+    uint64_t fill_inserts_max {};      // most inserts any one gap took to fill
+  };
+  const Counters& counters() const { return counters_; }
+
+  // How many pending segments were evicted (or new ones dropped) to stay within the budget?
+  uint64_t evictions() const { return counters_.evictions; }
 
   /*
    * Insert a new substring to be reassembled into a ByteStream.
    *   `first_index`: the index of the first byte of the substring
-   *   `data`: the substring itself
+   *   `data`: the substring itself (shared, not copied: in-order bytes are copied once, into the stream)
    *   `is_last_substring`: this substring represents the end of the stream
    *   `output`: a mutable reference to the Writer
    *
@@ -30,11 +106,16 @@ public:
    *
    * The Reassembler should close the stream after writing the last byte.
    */
-  void insert( uint64_t first_index, std::string data, bool is_last_substring );
+  void insert( uint64_t first_index, BufferSlice data, bool is_last_substring );
 
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
+  // The pending bytes as up to `max_intervals` disjoint [first, last) ranges of stream indices, for SACK:
+  // the range holding the most recently inserted bytes first, then those that were inserted into most
+  // recently before it, then any others from the lowest up.
+  std::vector<std::pair<uint64_t, uint64_t>> pending_intervals( size_t max_intervals ) const;
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -49,5 +130,39 @@ private:
   uint64_t pending_ { 0 };                 // the number of bytes pending to be written
   uint64_t last_index_ { 0 };              // the last index of the last substring
   bool received_last_ { false };           // whether the last substring has been received
-  std::map<scope, std::string> buffer_ {}; // the buffer to store the data
+  std::map<scope, BufferSlice> buffer_ {}; // pending segments: disjoint, but may touch
+  std::map<uint64_t, uint64_t> ranges_ {}; // the same bytes as maximal [first, last) ranges, keyed by first
+
+  void add_range( scope range );    // bytes that became pending (not already pending)
+  void remove_range( scope range ); // bytes that are no longer pending
+
+  // Direct placement: bit (i % present_bits_) of `present_` is set once byte i has been placed in the
+  // stream's free space, for i from index_ up to the end of the window (which never spans more bits).
+  Placement placement_;
+  std::vector<uint64_t> present_ {};
+  uint64_t present_bits_ { 0 };
+
+  void place( uint64_t first_index, std::string_view data );
+  uint64_t mark_present( uint64_t first_index, uint64_t last_index ); // returns how many bits were newly set
+  uint64_t present_run( uint64_t from ) const;                          // set bits from `from` onward
+  uint64_t present_run_before( uint64_t to ) const;                     // set bits just before `to`
+
+  // First indices of the latest inserts past index_, most recent first
+  static constexpr size_t max_recent_inserts = 4;
+  std::vector<uint64_t> recent_inserts_ {};
+  void note_recent_insert( uint64_t first_index );
+
+  std::optional<scope> interval_around( uint64_t index ) const; // the pending range holding `index`
+  scope next_interval( uint64_t from ) const;                    // the first pending range from `from` on
+
+  Counters counters_ {};
+  uint64_t gap_opened_at_ { 0 }; // value of counters_.inserts when the current gap opened
+
+  // Budget: the group this Reassembler charges
+  friend class ReassemblyBudget;
+  std::shared_ptr<ReassemblyBudget> budget_;
+
+  uint64_t furthest_pending() const; // how far past index_ the last pending segment ends (0 if none)
+  void evict_furthest();             // drop the last pending segment
+  void release( uint64_t bytes );    // `bytes` are no longer pending
 };
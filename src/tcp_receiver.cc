@@ -13,23 +13,37 @@ void TCPReceiver::receive( TCPSenderMessage message )
 
   if ( message.SYN ) {
     SYN_received_ = true;
+    SACK_permitted_ = message.SACK_permitted;
     zero_point = Wrap32 { message.seqno };
   }
 
   uint64_t stream_index
     = message.SYN ? 0 : message.seqno.unwrap( zero_point, abs_seqno_ ) - 1;
 
-  reassembler_.insert( stream_index, message.payload, message.FIN );
+  reassembler_.insert( stream_index, std::move( message.payload ), message.FIN );
   abs_seqno_ = 1 + writer().bytes_pushed() + writer().is_closed();
 }
 
+uint16_t TCPReceiver::window_size( bool SYN ) const
+{
+  const uint64_t window = writer().available_capacity() >> ( SYN ? 0 : window_shift_ );
+  return static_cast<uint16_t>( std::min( static_cast<uint64_t>( 0xffff ), window ) );
+}
+
 TCPReceiverMessage TCPReceiver::send() const
 {
+  std::vector<SACKBlock> sack;
+  if ( SACK_permitted_ && reassembler_.bytes_pending() ) {
+    for ( const auto& [first, last] : reassembler_.pending_intervals( TCPReceiverMessage::MAX_SACK_BLOCKS ) ) {
+      sack.push_back( { Wrap32::wrap( first + 1, zero_point ), Wrap32::wrap( last + 1, zero_point ) } );
+    }
+  }
+
   return TCPReceiverMessage {
     .ackno = SYN_received_ ? std::make_optional( Wrap32::wrap( abs_seqno_, zero_point ) )
                            : std::nullopt,
-    .window_size = static_cast<uint16_t>(
-      std::min( static_cast<uint64_t>( 0xffff ), writer().available_capacity() ) ),
+    .window_size = window_size(),
     .RST = writer().has_error(),
+    .sack = std::move( sack ),
   };
 }
@@ -21,15 +21,28 @@ public:
   // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
   TCPReceiverMessage send() const;
 
+  // RFC 7323: advertise the window in units of 2^shift bytes from now on (both SYNs carried the
+  // window-scale option)
+  void set_window_shift( uint8_t shift ) { window_shift_ = shift; }
+  uint8_t window_shift() const { return window_shift_; }
+
+  // The window send() advertises (a SYN's window is never scaled)
+  uint16_t window_size( bool SYN = false ) const;
+
   // Access the output (only Reader is accessible non-const)
   const Reassembler& reassembler() const { return reassembler_; }
   Reader& reader() { return reassembler_.reader(); }
   const Reader& reader() const { return reassembler_.reader(); }
   const Writer& writer() const { return reassembler_.writer(); }
 
+  // How the inbound stream has been reassembled so far
+  const Reassembler::Counters& reassembler_counters() const { return reassembler_.counters(); }
+
 private:
   Reassembler reassembler_;
   bool SYN_received_ { false };
+  bool SACK_permitted_ { false }; // did the peer's SYN permit SACK blocks?
+  uint8_t window_shift_ { 0 };
   Wrap32 zero_point { 0 };
   uint64_t abs_seqno_ { 0 };
 };
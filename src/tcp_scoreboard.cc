@@ -0,0 +1,200 @@
+#include "tcp_scoreboard.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+void Scoreboard::push_back( Segment&& seg )
+{
+  if ( !empty() && seg.seqno != at( size_ - 1 ).end() ) {
+    throw std::runtime_error( "Scoreboard: segment doesn't follow the last one" );
+  }
+
+  if ( size_ == ring_.size() ) {
+    // grow, unrolling the ring so the front is at position 0
+    std::vector<Segment> bigger( ring_.empty() ? 16 : ring_.size() * 2 );
+    for ( size_t i = 0; i < size_; ++i ) {
+      bigger[i] = std::move( at( i ) );
+    }
+    ring_ = std::move( bigger );
+    head_ = 0;
+  }
+
+  at( size_ ) = std::move( seg );
+  ++size_;
+}
+
+void Scoreboard::Delivery::add( const Delivery& other )
+{
+  bytes += other.bytes;
+  if ( other.newest.has_value() && ( !newest.has_value() || other.newest->sent_at >= newest->sent_at ) ) {
+    newest = other.newest;
+  }
+}
+
+Scoreboard::Delivery Scoreboard::ack( uint64_t ackno )
+{
+  Delivery delivery;
+  while ( !empty() && front().end() <= ackno ) {
+    Segment& seg = front();
+    if ( seg.lost && !seg.sacked && !seg.retransmitted ) {
+      lost_bytes_ -= seg.length();
+    }
+    if ( seg.sacked ) {
+      --sacked_count_;
+      sacked_bytes_ -= seg.length();
+      sacked_from_cursor_ -= seg.seqno >= loss_cursor_;
+    } else {
+      delivery.add( { seg.length(), seg.sent } );
+    }
+    seg = {};
+    head_ = ( head_ + 1 ) & ( ring_.size() - 1 );
+    --size_;
+  }
+  return delivery;
+}
+
+size_t Scoreboard::find( uint64_t seqno ) const
+{
+  size_t lo = 0;
+  size_t hi = size_;
+  while ( lo < hi ) {
+    const size_t mid = lo + ( hi - lo ) / 2;
+    if ( at( mid ).end() <= seqno ) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+Scoreboard::Delivery Scoreboard::sack( uint64_t left, uint64_t right )
+{
+  Delivery delivery;
+  for ( size_t i = find( left ); i < size_ && at( i ).end() <= right; ++i ) {
+    Segment& seg = at( i );
+    if ( seg.seqno >= left && !seg.sacked ) {
+      if ( seg.lost && !seg.retransmitted ) {
+        lost_bytes_ -= seg.length();
+      }
+      seg.sacked = true;
+      ++sacked_count_;
+      sacked_bytes_ += seg.length();
+      sacked_from_cursor_ += seg.seqno >= loss_cursor_;
+      delivery.add( { seg.length(), seg.sent } );
+    }
+  }
+  return delivery;
+}
+
+size_t Scoreboard::detect_losses()
+{
+  if ( sacked_from_cursor_ < DUP_THRESHOLD ) {
+    return 0;
+  }
+
+  // Move the cursor up to the DUP_THRESHOLD-th SACKed segment from the end. SACKs only ever add to
+  // what lies past it, so it never moves back, and over a connection it passes each segment once.
+  size_t threshold = find( loss_cursor_ );
+  while ( true ) {
+    while ( !at( threshold ).sacked ) {
+      ++threshold;
+    }
+    if ( sacked_from_cursor_ == DUP_THRESHOLD ) {
+      break;
+    }
+    --sacked_from_cursor_;
+    ++threshold;
+  }
+  loss_cursor_ = at( threshold ).seqno;
+
+  size_t newly_lost = 0;
+  for ( size_t i = find( loss_frontier_ ); i < threshold; ++i ) {
+    Segment& seg = at( i );
+    if ( !seg.sacked && !seg.lost ) {
+      seg.lost = true;
+      seg.retransmitted = false;
+      lost_bytes_ += seg.length();
+      ++newly_lost;
+    }
+  }
+  loss_frontier_ = std::max( loss_frontier_, at( threshold ).seqno );
+  return newly_lost;
+}
+
+bool Scoreboard::lose_front()
+{
+  return !empty() && lose( front().seqno );
+}
+
+bool Scoreboard::lose( uint64_t seqno )
+{
+  Segment* seg = segment_at( seqno );
+  if ( seg == nullptr || seg->lost || seg->sacked ) {
+    return false;
+  }
+  seg->lost = true;
+  seg->retransmitted = false;
+  lost_bytes_ += seg->length();
+  loss_frontier_ = std::max( loss_frontier_, seg->end() );
+  next_hole_ = std::min( next_hole_, seg->seqno );
+  return true;
+}
+
+Scoreboard::Segment* Scoreboard::segment_at( uint64_t seqno )
+{
+  const size_t i = find( seqno );
+  return i < size_ && at( i ).seqno == seqno ? &at( i ) : nullptr;
+}
+
+void Scoreboard::split( uint64_t seqno, size_t max_payload )
+{
+  const size_t i = find( seqno );
+  if ( i == size_ || at( i ).seqno != seqno || at( i ).sacked || at( i ).payload_size <= max_payload ) {
+    return;
+  }
+
+  // take the segment and those after it off the end, then put them back with the segment in pieces
+  std::vector<Segment> rest;
+  rest.reserve( size_ - i );
+  for ( size_t j = i; j < size_; ++j ) {
+    rest.push_back( std::exchange( at( j ), {} ) );
+  }
+  size_ = i;
+
+  const Segment whole = rest.front();
+  Segment piece = whole;
+  piece.FIN = false;
+  for ( size_t offset = 0; offset < whole.payload_size; offset += piece.payload_size ) {
+    piece.SYN = whole.SYN && offset == 0;
+    piece.seqno = offset == 0 ? whole.seqno : whole.seqno + whole.SYN + offset;
+    piece.payload_size = std::min( max_payload, whole.payload_size - offset );
+    piece.FIN = whole.FIN && offset + piece.payload_size == whole.payload_size;
+    push_back( Segment { piece } );
+  }
+  for ( size_t j = 1; j < rest.size(); ++j ) {
+    push_back( std::move( rest[j] ) );
+  }
+}
+
+Scoreboard::Segment* Scoreboard::next_hole()
+{
+  for ( size_t i = find( next_hole_ ); i < size_ && at( i ).seqno < loss_frontier_; ++i ) {
+    Segment& seg = at( i );
+    if ( seg.lost && !seg.sacked && !seg.retransmitted ) {
+      next_hole_ = seg.seqno;
+      return &seg;
+    }
+  }
+  next_hole_ = std::max( next_hole_, loss_frontier_ );
+  return nullptr;
+}
+
+void Scoreboard::mark_retransmitted( Segment& seg )
+{
+  if ( seg.lost && !seg.sacked && !seg.retransmitted ) {
+    lost_bytes_ -= seg.length();
+  }
+  seg.retransmitted = true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * The TCPSender's outstanding segments, in sequence-number order, along with what the receiver's
+ * SACK blocks have said about each (RFC 6675).
+ *
+ * The segments live in a ring that grows by doubling, so sending and acknowledging are O(1), and a
+ * segment is found from its (absolute) sequence number by binary search over the ring. They are only
+ * records: the payload stays in the sender's outbound stream until it's acknowledged.
+ */
+class Scoreboard
+{
+public:
+  // When a segment was last sent, and how much had been delivered by then (for RTT and delivery-rate
+  // samples)
+  struct SendRecord
+  {
+    uint64_t sent_at { 0 };
+    uint64_t delivered { 0 };     // bytes delivered (acked or SACKed) when it was sent
+    uint64_t delivered_at { 0 };  // when that count last grew
+    bool retransmitted { false }; // it has been sent more than once, so its RTT is ambiguous
+  };
+
+  struct Segment
+  {
+    bool SYN { false };
+    bool FIN { false };
+    bool RST { false };
+    uint64_t seqno { 0 };
+    size_t payload_size { 0 };
+
+    bool sacked { false };        // a SACK block has covered it: the receiver holds it
+    bool lost { false };          // enough SACKed segments were sent after it that it's presumed lost
+    bool retransmitted { false }; // resent since it was presumed lost
+    SendRecord sent {};
+
+    size_t length() const { return SYN + payload_size + FIN; }
+    uint64_t end() const { return seqno + length(); } // the sequence number just after it
+  };
+
+  // A segment is presumed lost once this many segments sent after it have been SACKed
+  static constexpr size_t DUP_THRESHOLD = 3;
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t sacked_count() const { return sacked_count_; }   // SACKed segments still outstanding
+  uint64_t sacked_bytes() const { return sacked_bytes_; } // ... and their sequence numbers
+  uint64_t lost_bytes() const { return lost_bytes_; }     // presumed lost and not resent: out of the pipe
+
+  Segment& front() { return at( 0 ); }
+  const Segment& front() const { return at( 0 ); }
+
+  // Add a segment sent for the first time (it must start where the last one ends)
+  void push_back( Segment&& seg );
+
+  // What an ack delivered for the first time
+  struct Delivery
+  {
+    uint64_t bytes { 0 };
+    std::optional<SendRecord> newest {}; // of the segment among them that was sent last
+
+    void add( const Delivery& other );
+  };
+
+  // Remove the segments that `ackno` acknowledges in full
+  Delivery ack( uint64_t ackno );
+
+  // Mark the segments that lie entirely within [left, right) as SACKed
+  Delivery sack( uint64_t left, uint64_t right );
+
+  // Presume lost the segments with at least DUP_THRESHOLD SACKed segments after them (a binary
+  // search, then amortized O(1): neither the threshold nor the segments checked so far move back).
+  // Returns how many were newly presumed lost.
+  size_t detect_losses();
+
+  // Presume the first segment lost (after duplicate acks), unless it's already presumed lost or
+  // SACKed. Returns whether it's newly presumed lost.
+  bool lose_front();
+
+  // The same for the segment that starts at `seqno`
+  bool lose( uint64_t seqno );
+
+  // The segment that starts at `seqno`, or nullptr if there is none
+  Segment* segment_at( uint64_t seqno );
+
+  // Replace the (unSACKed) segment that starts at `seqno` by segments of at most `max_payload` bytes
+  // each, which inherit its state (after a path MTU probe is lost, to resend it in pieces the path carries)
+  void split( uint64_t seqno, size_t max_payload );
+
+  // The first segment presumed lost that hasn't been retransmitted since, or nullptr if none
+  Segment* next_hole();
+
+  // Record that `seg` (one of the outstanding segments) was sent again, which puts it back in the pipe
+  void mark_retransmitted( Segment& seg );
+
+private:
+  std::vector<Segment> ring_ {}; // capacity is zero or a power of two
+  size_t head_ { 0 };
+  size_t size_ { 0 };
+  size_t sacked_count_ { 0 };
+  uint64_t sacked_bytes_ { 0 };
+  uint64_t lost_bytes_ { 0 };
+  uint64_t loss_frontier_ { 0 };    // segments before this seqno have been checked for loss
+  uint64_t loss_cursor_ { 0 };      // the DUP_THRESHOLD-th SACKed segment from the end starts here or later
+  size_t sacked_from_cursor_ { 0 }; // SACKed segments that start at or after loss_cursor_
+  uint64_t next_hole_ { 0 };        // no hole left to retransmit before this seqno
+
+  Segment& at( size_t i ) { return ring_[( head_ + i ) & ( ring_.size() - 1 )]; }
+  const Segment& at( size_t i ) const { return ring_[( head_ + i ) & ( ring_.size() - 1 )]; }
+
+  size_t find( uint64_t seqno ) const; // position of the first segment that ends after `seqno`
+};
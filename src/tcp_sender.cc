@@ -1,6 +1,11 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <string>
+
+static_assert( TCPSender::INITIAL_MSS == TCPConfig::MAX_PAYLOAD_SIZE );
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   return seq_current_ - ack_base_;
@@ -11,27 +16,119 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retransmissions_;
 }
 
+uint64_t TCPSender::unsent_bytes() const
+{
+  return reader().bytes_popped() + reader().bytes_buffered() - bytes_sent_;
+}
+
+bool TCPSender::finished_sending() const
+{
+  return writer().is_closed() && unsent_bytes() == 0;
+}
+
+// Nagle's algorithm, or autocorking: keep a short segment back for more bytes to join it
+bool TCPSender::hold_back( uint64_t payload_size ) const
+{
+  if ( payload_size >= max_payload() || sequence_numbers_in_flight() == 0 )
+    return false;
+  if ( writer().is_closed() && payload_size == unsent_bytes() )
+    return false; // nothing more is coming
+  switch ( coalescing_ ) {
+    case Coalescing::Off:
+      return false;
+    case Coalescing::Nagle:
+      return true;
+    case Coalescing::Autocork:
+      return last_sent_at_ == now_us_;
+  }
+  return false;
+}
+
+void TCPSender::set_mss( uint64_t mss, uint64_t probe_up_to )
+{
+  mss_ = mss;
+  search_high_ = std::max( mss, probe_up_to );
+  probe_failed_ = false;
+  if ( congestion_control_ )
+    congestion_control_->set_mss( mss );
+}
+
+uint64_t TCPSender::max_payload() const
+{
+  return mss_ > options_size_ ? mss_ - options_size_ : 1;
+}
+
+// Try the largest size first, so a path that carries it takes a single probe, then search between
+uint64_t TCPSender::next_probe_size() const
+{
+  if ( search_high_ < mss_ + PROBE_THRESHOLD )
+    return 0;
+  return probe_failed_ ? ( mss_ + search_high_ + 1 ) / 2 : search_high_;
+}
+
+void TCPSender::on_probe_lost()
+{
+  outstanding_.lose( *probe_seqno_ );
+  outstanding_.split( *probe_seqno_, mss_ );
+  search_high_ = probe_size_ - 1;
+  probe_failed_ = true;
+  probe_seqno_.reset();
+}
+
+uint64_t TCPSender::cwnd() const
+{
+  return congestion_control_ ? congestion_control_->cwnd() : UINT64_MAX;
+}
+
+uint64_t TCPSender::pacing_rate() const
+{
+  return congestion_control_ ? congestion_control_->pacing_rate() : 0;
+}
+
+uint64_t TCPSender::flight_size() const
+{
+  return seq_current_ - ack_base_ - outstanding_.sacked_bytes();
+}
+
+uint64_t TCPSender::pipe() const
+{
+  return flight_size() - outstanding_.lost_bytes();
+}
+
 void TCPSender::transmit_wrapper( Segment& seg, const TransmitFunction& transmit, bool track )
 {
+  // The payload is still in the outbound stream, which holds everything past the last ack
+  std::string payload;
+  if ( seg.payload_size > 0 ) {
+    const uint64_t offset = seg.seqno + seg.SYN - 1 - reader().bytes_popped();
+    payload.reserve( seg.payload_size );
+    while ( payload.size() < seg.payload_size ) {
+      payload.append( reader().peek( offset + payload.size() ).substr( 0, seg.payload_size - payload.size() ) );
+    }
+  }
+
   transmit( TCPSenderMessage {
     .seqno { Wrap32::wrap( seg.seqno, isn_ ) },
     .SYN = seg.SYN,
-    .payload { seg.data },
+    .payload { std::move( payload ) },
     .FIN = seg.FIN,
     .RST = seg.RST,
+    .SACK_permitted = seg.SYN,
   } );
+  seg.sent = { .sent_at = now_us_, .delivered = delivered_, .delivered_at = delivered_at_, .retransmitted = !track };
 
   if ( track ) {
     seq_current_ = std::max( seq_current_, seg.seqno + seg.length() );
-    buffer_.push( std::move( seg ) );
+    outstanding_.push_back( std::move( seg ) );
     if ( !timer.started() )
-      timer.restart();
+      timer.start( now_us_, RTO_us() );
   }
 }
 
 void TCPSender::push( const TransmitFunction& transmit )
 {
   Segment seg { .seqno = seq_current_ };
+  held_back_ = false;
 
   if ( input_.has_error() ) {
     seg.RST = true;
@@ -39,8 +136,29 @@ void TCPSender::push( const TransmitFunction& transmit )
     return;
   }
 
-  Reader& reader = input_.reader();
-  uint64_t seq_window = ack_base_ + ( window_size_ ? window_size_ : 1 );
+  // retransmit the holes the receiver's SACK blocks have revealed, as far as the windows allow (a
+  // presumed-lost segment is out of the pipe until it's resent); new data waits behind any left over
+  const uint64_t flight_limit = std::min( window_size_ ? window_size_ : 1, cwnd() );
+  while ( Segment* hole = outstanding_.next_hole() ) {
+    if ( !retransmit_first_ && pipe() + hole->length() > flight_limit )
+      return;
+    retransmit_first_ = false;
+    transmit_wrapper( *hole, transmit, false );
+    outstanding_.mark_retransmitted( *hole );
+  }
+  retransmit_first_ = false;
+
+  // the receiver's window, less any part of it the congestion window doesn't cover (what the receiver
+  // holds past a hole no longer counts against the congestion window; without SACK, each of the first
+  // two duplicate acks lets one more segment out instead)
+  uint64_t window = window_size_ ? window_size_ : 1;
+  if ( congestion_control_ ) {
+    uint64_t limited_transmit = 0;
+    if ( !in_recovery_ && outstanding_.sacked_count() == 0 )
+      limited_transmit = std::min<uint64_t>( dup_acks_, 2 ) * mss_;
+    window = std::min( window, cwnd() + outstanding_.sacked_bytes() + limited_transmit );
+  }
+  uint64_t seq_window = ack_base_ + window;
   if ( seq_window < seq_current_ )
     return;
   uint64_t max_seq_size = seq_window - seq_current_;
@@ -48,21 +166,34 @@ void TCPSender::push( const TransmitFunction& transmit )
   if ( seg.length() < max_seq_size )
     seg.SYN = ( seq_current_ == 0 );
 
-  while ( reader.bytes_buffered() != 0 && max_seq_size > 0 ) {
-    uint64_t max_data_size = std::min( TCPConfig::MAX_PAYLOAD_SIZE, max_seq_size - seg.length() );
-    seg.data = reader.peek().substr( 0, max_data_size );
-    reader.pop( seg.data.size() );
+  while ( unsent_bytes() != 0 && max_seq_size > 0 ) {
+    // one probe at a time, only of new data, and not while repairing a loss
+    const uint64_t probe = probe_seqno_ || in_recovery_ || seg.SYN ? 0 : next_probe_size();
+    if ( probe > 0 && probe <= std::min( max_seq_size, unsent_bytes() ) ) {
+      seg.payload_size = probe;
+      probe_seqno_ = seg.seqno;
+      probe_size_ = probe;
+    } else {
+      seg.payload_size = std::min( { max_payload(), max_seq_size - seg.length(), unsent_bytes() } );
+      if ( hold_back( seg.payload_size ) ) {
+        seg.payload_size = 0;
+        held_back_ = true;
+        break;
+      }
+    }
+    bytes_sent_ += seg.payload_size;
+    last_sent_at_ = now_us_;
 
     if ( seg.length() < max_seq_size )
-      seg.FIN = reader.is_finished();
+      seg.FIN = finished_sending();
 
     transmit_wrapper( seg, transmit );
     max_seq_size = seq_window - seq_current_;
     seg = { .seqno = seq_current_ };
   }
 
-  if ( seq_current_ <= reader.bytes_popped() + 1 && seg.length() < max_seq_size )
-    seg.FIN = reader.is_finished();
+  if ( seq_current_ <= bytes_sent_ + 1 && seg.length() < max_seq_size )
+    seg.FIN = finished_sending();
 
   if ( seg.length() > 0 )
     transmit_wrapper( seg, transmit );
@@ -76,46 +207,176 @@ TCPSenderMessage TCPSender::make_empty_message() const
   };
 }
 
-void TCPSender::receive( const TCPReceiverMessage& msg )
+void TCPSender::receive( const TCPReceiverMessage& msg, bool with_data )
 {
   if ( msg.RST )
     input_.set_error();
 
-  window_size_ = msg.window_size;
+  const uint64_t window_size = uint64_t { msg.window_size } << window_shift_;
+  const bool window_changed = window_size_ != window_size;
+  window_size_ = window_size;
 
   if ( msg.ackno.has_value() ) {
+    Scoreboard::Delivery delivery;
+    bool restart_timer = false;
     uint64_t ack_no = msg.ackno.value().unwrap( isn_, ack_base_ );
+
+    if ( ack_no > last_ackno_ && ack_no <= seq_current_ ) {
+      last_ackno_ = ack_no;
+      dup_acks_ = 0;
+    } else if ( ack_no == last_ackno_ && !outstanding_.empty() && !window_changed && !with_data ) {
+      ++dup_acks_;
+    }
+
     if ( ack_no > ack_base_ && ack_no <= seq_current_ ) {
       if ( RTO_ratio_ != 1 ) {
         RTO_ratio_ = 1;
         consecutive_retransmissions_ = 0;
-        timer.restart();
+        restart_timer = true;
       }
 
-      while ( !buffer_.empty() ) {
-        Segment& seg = buffer_.front();
-        if ( seg.seqno + seg.length() > ack_no )
-          break;
-        ack_base_ = seg.seqno + seg.length();
-        buffer_.pop();
-        timer.restart();
+      if ( !outstanding_.empty() && outstanding_.front().end() <= ack_no ) {
+        delivery.add( outstanding_.ack( ack_no ) );
+        ack_base_ = outstanding_.empty() ? ack_no : outstanding_.front().seqno;
+        restart_timer = true;
+
+        // the acked bytes (not the SYN or FIN) can leave the stream
+        const uint64_t acked_bytes = std::min( ack_base_ - 1, bytes_sent_ );
+        input_.reader().pop( acked_bytes - reader().bytes_popped() );
       }
+    }
+
+    for ( const auto& block : msg.sack ) {
+      const uint64_t left = block.left.unwrap( isn_, ack_base_ );
+      const uint64_t right = block.right.unwrap( isn_, ack_base_ );
+      if ( left >= ack_base_ && left < right && right <= seq_current_ )
+        delivery.add( outstanding_.sack( left, right ) );
+    }
+
+    // Karn's rule: a retransmitted segment's ack might be for either copy
+    if ( delivery.newest.has_value() && !delivery.newest->retransmitted )
+      sample_rtt( now_us_ - delivery.newest->sent_at );
+
+    if ( outstanding_.empty() )
+      timer.stop();
+    else if ( restart_timer )
+      timer.start( now_us_, RTO_us() );
+
+    on_delivery( delivery );
+
+    // a delivered probe raises the MSS
+    const Segment* probe = probe_seqno_ ? outstanding_.segment_at( *probe_seqno_ ) : nullptr;
+    if ( probe_seqno_ && ( probe == nullptr || probe->sacked ) ) {
+      mss_ = probe_size_;
+      probe_seqno_.reset();
+      if ( congestion_control_ )
+        congestion_control_->set_mss( mss_ );
+    }
 
-      if ( buffer_.empty() )
-        timer.stop();
+    // fast retransmit: push() resends whatever is newly presumed lost
+    size_t lost = outstanding_.detect_losses();
+    if ( dup_acks_ == Scoreboard::DUP_THRESHOLD )
+      lost += outstanding_.lose_front();
+    if ( probe != nullptr && probe->lost ) {
+      --lost;
+      on_probe_lost();
     }
+    if ( lost > 0 && !in_recovery_ )
+      enter_recovery( false );
+
+    // a congestion-experienced mark counts as a loss
+    if ( msg.ECE && !in_recovery_ )
+      enter_recovery( true );
+  }
+}
+
+// Reduce the congestion window once per window of data
+void TCPSender::enter_recovery( bool ecn )
+{
+  if ( congestion_control_ && ecn )
+    congestion_control_->on_ecn( now_us_, flight_size() );
+  else if ( congestion_control_ )
+    congestion_control_->on_loss( now_us_, flight_size() );
+  in_recovery_ = true;
+  recovery_point_ = seq_current_;
+  retransmit_first_ = !ecn;
+}
+
+void TCPSender::on_delivery( const Scoreboard::Delivery& delivery )
+{
+  if ( in_recovery_ && ack_base_ >= recovery_point_ )
+    in_recovery_ = false;
+
+  if ( delivery.bytes == 0 )
+    return;
+
+  delivered_ += delivery.bytes;
+  delivered_at_ = now_us_;
+
+  if ( !congestion_control_ )
+    return;
+
+  CongestionControl::Ack ack {
+    .now = now_us_,
+    .bytes_acked = delivery.bytes,
+    .bytes_in_flight = pipe(),
+    .in_recovery = in_recovery_,
+    .delivered = delivered_,
+  };
+  if ( delivery.newest.has_value() ) {
+    const auto& sent = *delivery.newest;
+    if ( !sent.retransmitted )
+      ack.rtt = now_us_ - sent.sent_at;
+    ack.prior_delivered = sent.delivered;
+    // the delivery rate since the count the segment was sent at was reached
+    const uint64_t interval = now_us_ - sent.delivered_at;
+    if ( interval > 0 )
+      ack.delivery_rate = ( delivered_ - sent.delivered ) * 1'000'000 / interval;
+  }
+  congestion_control_->on_ack( ack );
+}
+
+// RFC 6298 (2.2, 2.3)
+void TCPSender::sample_rtt( uint64_t rtt_us )
+{
+  if ( !srtt_us_.has_value() ) {
+    srtt_us_ = rtt_us;
+    rttvar_us_ = rtt_us / 2;
+  } else {
+    const uint64_t deviation = *srtt_us_ > rtt_us ? *srtt_us_ - rtt_us : rtt_us - *srtt_us_;
+    rttvar_us_ = ( 3 * rttvar_us_ + deviation ) / 4;
+    srtt_us_ = ( 7 * *srtt_us_ + rtt_us ) / 8;
   }
+  RTO_us_ = *srtt_us_ + std::max( rto_bounds_.granularity_us, 4 * rttvar_us_ );
+  RTO_us_ = std::min( std::max( RTO_us_, rto_bounds_.min_us ), rto_bounds_.max_us );
 }
 
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
-  timer.tick( ms_since_last_tick );
-  if ( timer.expired( RTO_ratio_ * initial_RTO_ms_ ) ) {
-    if ( window_size_ != 0 ) {
-      consecutive_retransmissions_++;
-      RTO_ratio_ *= 2;
+  tick_us( ms_since_last_tick * 1000, transmit );
+}
+
+void TCPSender::tick_us( uint64_t us_since_last_tick, const TransmitFunction& transmit )
+{
+  now_us_ += us_since_last_tick;
+  if ( timer.expired( now_us_ ) ) {
+    if ( probe_seqno_ == outstanding_.front().seqno ) {
+      on_probe_lost();
+    } else {
+      in_recovery_ = false;
+      if ( window_size_ != 0 ) {
+        if ( congestion_control_ )
+          congestion_control_->on_timeout( now_us_, flight_size() );
+        consecutive_retransmissions_++;
+        RTO_ratio_ *= 2;
+      }
     }
-    timer.restart();
-    transmit_wrapper( buffer_.front(), transmit, false );
+    timer.start( now_us_, RTO_us() );
+    transmit_wrapper( outstanding_.front(), transmit, false );
+    outstanding_.mark_retransmitted( outstanding_.front() );
   }
+
+  // autocorked bytes go out once the clock moves on, without waiting for the next push
+  if ( held_back_ && us_since_last_tick > 0 )
+    push( transmit );
 }
@@ -1,49 +1,74 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "coalescing.hh"
+#include "congestion_control.hh"
 #include "tcp_receiver_message.hh"
+#include "tcp_scoreboard.hh"
 #include "tcp_sender_message.hh"
 
 #include <cstdint>
 #include <functional>
-#include <queue>
+#include <memory>
+#include <optional>
 
+// The retransmission timer: a deadline on the sender's microsecond clock
 class Timer
 {
 public:
   Timer() = default;
   bool started() const { return started_; }
   void stop() { started_ = false; }
-  void restart()
+  void start( uint64_t now, uint64_t timeout )
   {
-    time_ = 0;
+    deadline_ = now + timeout;
     started_ = true;
   }
-  void tick( uint64_t ms )
-  {
-    if ( started_ )
-      time_ += ms;
-  }
-  bool expired( uint64_t ms ) const { return started_ && time_ >= ms; }
+  bool expired( uint64_t now ) const { return started_ && now >= deadline_; }
 
 private:
   bool started_ { false };
-  uint64_t time_ { 0 };
+  uint64_t deadline_ { 0 };
 };
 
 class TCPSender
 {
 public:
-  /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms )
+  // Bounds on the retransmission timeout that the RTT estimate yields, and the clock granularity G
+  // (RFC 6298: the RTO is at least G above the SRTT), all in microseconds
+  struct RTOBounds
+  {
+    uint64_t min_us;
+    uint64_t max_us;
+    uint64_t granularity_us { 1000 };
+  };
+
+  // Payload size until set_mss() (TCPConfig::MAX_PAYLOAD_SIZE)
+  static constexpr uint64_t INITIAL_MSS = 1000;
+
+  /* Construct TCP sender with given default Retransmission Timeout and possible ISN
+   * (without a congestion controller, only the receiver's window limits what is in flight;
+   * without RTO bounds, the RTO stays at initial_RTO_ms apart from backing off) */
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             std::unique_ptr<CongestionControl> congestion_control = {},
+             std::optional<RTOBounds> rto_bounds = {},
+             Coalescing coalescing = Coalescing::Off )
+    : input_( std::move( input ) )
+    , isn_( isn )
+    , initial_RTO_ms_( initial_RTO_ms )
+    , congestion_control_( std::move( congestion_control ) )
+    , rto_bounds_( rto_bounds.value_or( RTOBounds { initial_RTO_ms * 1000, initial_RTO_ms * 1000 } ) )
+    , coalescing_( coalescing )
   {}
 
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
 
-  /* Receive and process a TCPReceiverMessage from the peer's receiver */
-  void receive( const TCPReceiverMessage& msg );
+  /* Receive and process a TCPReceiverMessage from the peer's receiver
+   * (`with_data`: it came with data for our receiver, so it can't count as a duplicate ack) */
+  void receive( const TCPReceiverMessage& msg, bool with_data = false );
 
   /* Type of the `transmit` function that the push and tick methods can use to send
    * messages */
@@ -56,6 +81,9 @@ public:
    * was called */
   void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
 
+  /* The same, in microseconds */
+  void tick_us( uint64_t us_since_last_tick, const TransmitFunction& transmit );
+
   // Accessors
   uint64_t sequence_numbers_in_flight()
     const; // How many sequence numbers are outstanding?
@@ -64,33 +92,105 @@ public:
   Writer& writer() { return input_.writer(); }
   const Writer& writer() const { return input_.writer(); }
 
-  // Access input stream reader, but const-only (can't read from outside)
+  /* Size segments by `mss`, the largest payload the path is known to carry; when `probe_up_to` (what the
+   * peer accepts) is larger, search for the path's real limit with packetization-layer path MTU discovery
+   * (RFC 4821): now and then a segment that much larger goes out as a probe, and if it's delivered, the
+   * MSS grows to its size */
+  void set_mss( uint64_t mss, uint64_t probe_up_to = 0 );
+  uint64_t mss() const { return mss_; }
+
+  // Bytes of TCP options (the receiver's SACK blocks) that the next segments carry: new data leaves them
+  // room within the MSS
+  void set_options_size( uint64_t size ) { options_size_ = size; }
+  bool probing() const { return probe_seqno_.has_value(); } // a probe is in flight
+
+  // Access input stream reader, but const-only (can't read from outside). Bytes stay buffered until they
+  // are acknowledged, so bytes_popped() counts the acked bytes and is_finished() waits for the last ack.
   const Reader& reader() const { return input_.reader(); }
 
+  // Has every byte of the closed outbound stream been sent at least once? (The FIN may still be waiting
+  // for room in the window.)
+  bool finished_sending() const;
+
+  // The outstanding segments, and what the receiver's SACK blocks have said about them
+  const Scoreboard& scoreboard() const { return outstanding_; }
+
+  // RFC 7323: the peer's windows are in units of 2^shift bytes from now on
+  void set_window_shift( uint8_t shift ) { window_shift_ = shift; }
+  uint64_t window_size() const { return window_size_; } // the peer's last window, in bytes
+
+  // Congestion control (cwnd is UINT64_MAX and pacing_rate is 0 without a controller)
+  uint64_t cwnd() const;
+  uint64_t pacing_rate() const; // bytes per second; not enforced by push()
+  bool in_recovery() const { return in_recovery_; }
+  const CongestionControl* congestion_control() const { return congestion_control_.get(); }
+
+  // RTT estimate (RFC 6298), in microseconds; empty until the first sample
+  std::optional<uint64_t> srtt_us() const { return srtt_us_; }
+  uint64_t rttvar_us() const { return rttvar_us_; }
+  uint64_t RTO_us() const { return RTO_us_ * RTO_ratio_; } // the current timeout, backoff included
+
 private:
   // Variables initialized in constructor
   ByteStream input_;
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
+  std::unique_ptr<CongestionControl> congestion_control_;
+  RTOBounds rto_bounds_;
+  Coalescing coalescing_;
 
   // Helper functions and variables
-  struct Segment
-  {
-    bool SYN { false };
-    bool FIN { false };
-    bool RST { false };
-    uint64_t seqno { 0 };
-    std::string data {};
-    size_t length() const { return SYN + data.size() + FIN; }
-  };
+  using Segment = Scoreboard::Segment;
   void transmit_wrapper( Segment& seg,
                          const TransmitFunction& transmit,
                          bool track = true );
-  std::queue<Segment> buffer_ {};
+  Scoreboard outstanding_ {};
   Timer timer {};
+  uint64_t RTO_us_ { initial_RTO_ms_ * 1000 };
   uint64_t RTO_ratio_ { 1 };
   uint64_t ack_base_ { 0 };
   uint64_t seq_current_ { 0 };
-  uint16_t window_size_ { 1 }; // Assume window size is 1 before SYN
+  uint64_t bytes_sent_ { 0 }; // stream bytes sent at least once (the reader's bytes_popped() are acked)
+  uint64_t unsent_bytes() const;
+  uint64_t last_sent_at_ { 0 }; // when new data was last sent (for Autocork)
+  bool hold_back( uint64_t payload_size ) const;
+  bool held_back_ { false }; // the last push() kept a short segment back
+  uint64_t window_size_ { 1 }; // Assume window size is 1 before SYN
+  uint8_t window_shift_ { 0 };
   uint64_t consecutive_retransmissions_ { 0 };
+
+  // Path MTU discovery: a lost probe is resent in MSS-sized pieces without a window reduction (it says
+  // the path doesn't carry segments that large, not that it's congested), and the search goes on below it
+  static constexpr uint64_t PROBE_THRESHOLD = 32; // bytes: the search stops once it's narrowed this far
+  uint64_t mss_ { INITIAL_MSS };
+  uint64_t options_size_ { 0 };
+  uint64_t max_payload() const; // the MSS less the options' room
+  uint64_t search_high_ { INITIAL_MSS }; // the largest payload that might get through
+  bool probe_failed_ { false };          // once a probe is lost, binary search; before, try search_high_
+  std::optional<uint64_t> probe_seqno_ {};
+  uint64_t probe_size_ { 0 };
+  uint64_t next_probe_size() const; // 0 when the search is over
+  void on_probe_lost();
+
+  // RTT estimation
+  std::optional<uint64_t> srtt_us_ {};
+  uint64_t rttvar_us_ { 0 };
+  void sample_rtt( uint64_t rtt_us );
+
+  // Duplicate acks (RFC 5681): the third one retransmits the first outstanding segment, and the first
+  // two may each send a new segment past the congestion window (limited transmit, RFC 3042)
+  uint64_t last_ackno_ { 0 };
+  uint64_t dup_acks_ { 0 };
+
+  // Congestion-control state
+  uint64_t now_us_ { 0 };         // the sender's clock, advanced by tick()
+  uint64_t delivered_ { 0 };      // sequence numbers acked or SACKed so far
+  uint64_t delivered_at_ { 0 };   // when delivered_ last grew
+  bool in_recovery_ { false };    // repairing a loss: no further window reductions until...
+  uint64_t recovery_point_ { 0 }; // ...everything sent before the loss was detected is acked
+  bool retransmit_first_ { false }; // the first hole goes out whatever the windows (RFC 6675 5, step 4.3)
+  uint64_t flight_size() const;   // outstanding sequence numbers the receiver doesn't hold
+  uint64_t pipe() const;          // ... less those presumed lost and not yet resent (RFC 6675)
+  void on_delivery( const Scoreboard::Delivery& delivery );
+  void enter_recovery( bool ecn );
 };
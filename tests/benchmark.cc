@@ -0,0 +1,192 @@
+#include "benchmark.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <span>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+uint64_t allocations = 0;
+uint64_t heap_in_use = 0;
+uint64_t heap_peak = 0;
+}
+
+void* operator new( size_t size )
+{
+  void* ptr = malloc( size ? size : 1 );
+  if ( not ptr ) {
+    throw bad_alloc {};
+  }
+  ++allocations;
+  heap_in_use += malloc_usable_size( ptr );
+  heap_peak = max( heap_peak, heap_in_use );
+  return ptr;
+}
+
+void* operator new[]( size_t size )
+{
+  return operator new( size );
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  if ( ptr ) {
+    heap_in_use -= malloc_usable_size( ptr );
+    free( ptr );
+  }
+}
+
+void operator delete[]( void* ptr ) noexcept
+{
+  operator delete( ptr );
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  operator delete( ptr );
+}
+
+void operator delete[]( void* ptr, size_t /* size */ ) noexcept
+{
+  operator delete( ptr );
+}
+
+uint64_t HeapCounter::allocations()
+{
+  return ::allocations;
+}
+
+uint64_t HeapCounter::in_use()
+{
+  return heap_in_use;
+}
+
+uint64_t HeapCounter::peak()
+{
+  return heap_peak;
+}
+
+void HeapCounter::reset_peak()
+{
+  heap_peak = heap_in_use;
+}
+
+namespace {
+
+void print_text( const vector<Column>& columns, const vector<Row>& rows )
+{
+  // headers are aligned like their column: text to the left, numbers to the right
+  for ( size_t i = 0; i < columns.size(); ++i ) {
+    if ( not columns[i].label.empty() ) {
+      const bool text = not rows.empty() and holds_alternative<string>( rows.front().at( i ) );
+      cout << ( text ? left : right ) << setw( columns[i].width ) << columns[i].label;
+    }
+  }
+  cout << "\n";
+
+  for ( const auto& row : rows ) {
+    for ( size_t i = 0; i < columns.size(); ++i ) {
+      const Column& col = columns[i];
+      if ( col.label.empty() ) {
+        continue;
+      }
+      if ( const auto* str = get_if<string>( &row.at( i ) ) ) {
+        cout << left << setw( col.width ) << *str;
+      } else if ( const auto* num = get_if<uint64_t>( &row.at( i ) ) ) {
+        cout << right << setw( col.width ) << *num;
+      } else {
+        cout << right << fixed << setprecision( col.precision ) << setw( col.width ) << get<double>( row.at( i ) );
+      }
+    }
+    cout << "\n";
+  }
+}
+
+void print_value( const Value& value, const bool quote_strings )
+{
+  if ( const auto* str = get_if<string>( &value ) ) {
+    cout << ( quote_strings ? "\"" + *str + "\"" : *str );
+  } else if ( const auto* num = get_if<uint64_t>( &value ) ) {
+    cout << *num;
+  } else {
+    cout << defaultfloat << setprecision( 6 ) << get<double>( value );
+  }
+}
+
+void print_csv( const vector<Column>& columns, const vector<Row>& rows )
+{
+  for ( size_t i = 0; i < columns.size(); ++i ) {
+    cout << ( i ? "," : "" ) << columns[i].key;
+  }
+  cout << "\n";
+
+  for ( const auto& row : rows ) {
+    for ( size_t i = 0; i < columns.size(); ++i ) {
+      cout << ( i ? "," : "" );
+      print_value( row.at( i ), false );
+    }
+    cout << "\n";
+  }
+}
+
+void print_json( const vector<Column>& columns, const vector<Row>& rows )
+{
+  cout << "[\n";
+  for ( size_t r = 0; r < rows.size(); ++r ) {
+    cout << "  {";
+    for ( size_t i = 0; i < columns.size(); ++i ) {
+      cout << ( i ? ", " : "" ) << "\"" << columns[i].key << "\": ";
+      print_value( rows[r].at( i ), true );
+    }
+    cout << "}" << ( r + 1 < rows.size() ? ",\n" : "\n" );
+  }
+  cout << "]\n";
+}
+
+} // namespace
+
+void print( const vector<Column>& columns, const vector<Row>& rows, const Format format )
+{
+  switch ( format ) {
+    case Format::Text:
+      print_text( columns, rows );
+      break;
+    case Format::CSV:
+      print_csv( columns, rows );
+      break;
+    case Format::JSON:
+      print_json( columns, rows );
+      break;
+  }
+}
+
+int benchmark_main( int argc, char* argv[], const function<void( Format )>& body )
+{
+  try {
+    auto format = Format::Text;
+    for ( const string_view arg : span( argv, argc ).subspan( 1 ) ) {
+      if ( arg == "--csv" ) {
+        format = Format::CSV;
+      } else if ( arg == "--json" ) {
+        format = Format::JSON;
+      } else {
+        cerr << "Usage: " << argv[0] << " [--csv | --json]\n";
+        return EXIT_FAILURE;
+      }
+    }
+
+    body( format );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Heap use over the whole program, counted by the operator new and delete that benchmark.cc replaces
+class HeapCounter
+{
+public:
+  static uint64_t allocations(); // calls to operator new so far
+  static uint64_t in_use();      // bytes allocated and not yet freed
+  static uint64_t peak();        // the most bytes in use since the last reset_peak()
+  static void reset_peak();
+};
+
+// A message on its way across a simulated link, due at the other end at `arrival` (microseconds)
+template<class Message>
+struct InFlight
+{
+  uint64_t arrival;
+  Message msg;
+};
+
+// How a benchmark prints its results: an aligned table, or CSV or JSON (--csv, --json) for scripts
+enum class Format : uint8_t
+{
+  Text,
+  CSV,
+  JSON,
+};
+
+// One column of a benchmark's results
+struct Column
+{
+  std::string key;     // the CSV header and JSON field
+  std::string label;   // the text table's header, or empty to leave the column out of the table
+  int width {};        // in the text table
+  int precision { 2 }; // digits after the point of a double in the text table
+};
+
+using Value = std::variant<std::string, uint64_t, double>;
+using Row = std::vector<Value>; // one Value per Column
+
+void print( const std::vector<Column>& columns, const std::vector<Row>& rows, Format format );
+
+// Parses the --csv or --json argument, runs `body`, and reports any exception; returns the exit status
+int benchmark_main( int argc, char* argv[], const std::function<void( Format )>& body );
@@ -0,0 +1,95 @@
+#include "buffer_slice.hh"
+#include "reassembler.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+bool within( const BufferSlice& slice, const BufferSlice& buffer )
+{
+  return slice.data() >= buffer.data() and slice.data() + slice.size() <= buffer.data() + buffer.size();
+}
+
+void test_slices()
+{
+  const BufferSlice whole { "abcdefgh" };
+  const BufferSlice middle = whole.substr( 2, 4 );
+  test_should_be( middle == "cdef", true );
+  test_should_be( middle.data() == whole.data() + 2, true ); // shares the buffer
+
+  BufferSlice trimmed = whole;
+  trimmed.remove_prefix( 1 );
+  trimmed.remove_suffix( 2 );
+  test_should_be( trimmed == "bcdef", true );
+  test_should_be( within( trimmed, whole ), true ); // trimmed in place
+  test_should_be( whole == "abcdefgh", true );
+
+  // a short slice of a large buffer gets a buffer of its own; a slice of most of one doesn't
+  const BufferSlice large { string( 16384, 'x' ) };
+  BufferSlice pinned = large.substr( 100, 10 );
+  pinned.shrink_to_fit();
+  test_should_be( pinned == string( 10, 'x' ), true );
+  test_should_be( within( pinned, large ), false );
+  BufferSlice most = large.substr( 100 );
+  most.shrink_to_fit();
+  test_should_be( within( most, large ), true );
+}
+
+void test_parse()
+{
+  TCPSegment seg;
+  seg.message.sender.seqno = Wrap32 { 1000 };
+  seg.message.sender.payload = string( 500, 'p' );
+  seg.compute_checksum( 0 );
+  string serialized;
+  for ( const auto& buffer : serialize( seg ) ) {
+    serialized += buffer;
+  }
+
+  // the parsed payload is the tail of the buffer it was parsed from
+  const BufferSlice received { serialized };
+  TCPSegment parsed;
+  test_should_be( parse( parsed, { received }, 0 ), true );
+  test_should_be( parsed.message.sender.payload == string( 500, 'p' ), true );
+  test_should_be( within( parsed.message.sender.payload, received ), true );
+
+  // a payload split across buffers is put back together
+  TCPSegment split;
+  test_should_be( parse( split, { received.substr( 0, 300 ), received.substr( 300 ) }, 0 ), true );
+  test_should_be( split.message.sender.payload == string( 500, 'p' ), true );
+}
+
+void test_reassembler()
+{
+  Reassembler r { ByteStream { 100 } };
+  const BufferSlice buffer { "0123456789" };
+  r.insert( 6, buffer.substr( 6 ), true );
+  test_should_be( r.bytes_pending(), uint64_t { 4 } );
+  r.insert( 0, buffer.substr( 0, 6 ), false );
+  test_should_be( r.reader().peek() == "0123456789", true );
+  test_should_be( r.writer().is_closed(), true );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    test_slices();
+    test_parse();
+    test_reassembler();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
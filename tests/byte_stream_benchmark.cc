@@ -0,0 +1,162 @@
+#include "benchmark.hh"
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct Result
+{
+  string storage {};
+  size_t capacity {};
+  size_t write_size {};
+  size_t read_size {};
+  size_t bytes {};
+  uint64_t ops {}; // pushes plus pops
+  double seconds {};
+  uint64_t allocations {};
+
+  double gigabits_per_second() const { return 8 * static_cast<double>( bytes ) / seconds / 1e9; }
+  double ns_per_op() const { return seconds * 1e9 / static_cast<double>( ops ); }
+};
+
+// Stream `data` through a ByteStream, pushing `write_size` bytes and popping up to `read_size` at a time.
+Result run( const string& data,
+            const ByteStream::Storage storage,
+            const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+            const size_t write_size, // NOLINT(bugprone-easily-swappable-parameters)
+            const size_t read_size ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  // Split the data before timing, so only the stream's own allocations are counted
+  vector<string> writes;
+  writes.reserve( data.size() / write_size + 1 );
+  for ( size_t i = 0; i < data.size(); i += write_size ) {
+    writes.emplace_back( data.substr( i, write_size ) );
+  }
+
+  ByteStream bs { capacity, storage };
+  string output;
+  output.reserve( data.size() );
+
+  auto next_write = writes.begin();
+  uint64_t ops = 0;
+  const uint64_t allocations_before = HeapCounter::allocations();
+  const auto start_time = steady_clock::now();
+  while ( not bs.reader().is_finished() ) {
+    if ( next_write == writes.end() ) {
+      if ( not bs.writer().is_closed() ) {
+        bs.writer().close();
+      }
+    } else if ( next_write->size() <= bs.writer().available_capacity() ) {
+      bs.writer().push( move( *next_write ) );
+      ++next_write;
+      ++ops;
+    }
+
+    if ( bs.reader().bytes_buffered() ) {
+      const auto peeked = bs.reader().peek().substr( 0, read_size );
+      output.append( peeked );
+      bs.reader().pop( peeked.size() );
+      ++ops;
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t stream_allocations = HeapCounter::allocations() - allocations_before;
+
+  if ( data != output ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  return { .storage = storage_name( bs.storage() ),
+           .capacity = capacity,
+           .write_size = write_size,
+           .read_size = read_size,
+           .bytes = data.size(),
+           .ops = ops,
+           .seconds = duration_cast<duration<double>>( stop_time - start_time ).count(),
+           .allocations = stream_allocations };
+}
+
+void print( const vector<Result>& results, const Format format )
+{
+  const vector<Column> columns { { "storage", "storage", 10 },
+                                 { "capacity", "capacity", 10 },
+                                 { "write_size", "write", 8 },
+                                 { "read_size", "read", 8 },
+                                 { "bytes", "" },
+                                 { "ops", "" },
+                                 { "seconds", "" },
+                                 { "gbit_per_s", "Gbit/s", 10 },
+                                 { "ns_per_op", "ns/op", 10 },
+                                 { "allocations", "allocs", 8 } };
+  vector<Row> rows;
+  for ( const auto& r : results ) {
+    rows.push_back( { r.storage,
+                      r.capacity,
+                      r.write_size,
+                      r.read_size,
+                      r.bytes,
+                      r.ops,
+                      r.seconds,
+                      r.gigabits_per_second(),
+                      r.ns_per_op(),
+                      r.allocations } );
+  }
+  ::print( columns, rows, format );
+}
+
+void program_body( const Format format )
+{
+  // Reserve the pool's arena before timing anything
+  static_cast<void>( BufferPool::global().borrow() );
+
+  // Enough data for about a million operations at the smallest size, capped at 16 MiB
+  constexpr size_t max_ops = 1 << 20;
+  constexpr size_t max_bytes = 1 << 24;
+  const string data = [] {
+    default_random_engine rd { 789 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < max_bytes; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  vector<Result> results;
+  for ( const auto storage : { ByteStream::Storage::Ring,
+                               ByteStream::Storage::Mirrored,
+                               ByteStream::Storage::Chunked,
+                               ByteStream::Storage::Pooled } ) {
+    for ( const size_t capacity : { 4096UL, 65536UL, 1UL << 20 } ) {
+      for ( const size_t write_size : { 1UL, 1500UL, 65536UL } ) {
+        if ( write_size > capacity ) {
+          continue;
+        }
+        for ( const size_t read_size : { 1UL, 128UL, 65536UL } ) {
+          const size_t len = min( max_bytes, max_ops * min( write_size, read_size ) );
+          results.push_back( run( data.substr( 0, len ), storage, capacity, write_size, read_size ) );
+        }
+      }
+    }
+  }
+
+  print( results, format );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return benchmark_main( argc, argv, program_body );
+}
@@ -0,0 +1,71 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "chunked-basics", 15, ByteStream::Storage::Chunked };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "" } );
+      test.execute( Push { "tac" } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+
+      // peek() gives the rest of the oldest pushed string
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Peek { "cattac" } );
+
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "t" } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "ac" } );
+      test.execute( BytesPopped { 4 } );
+      test.execute( AvailableCapacity { 13 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked-overwrite", 10, ByteStream::Storage::Chunked };
+
+      test.execute( Push { "0123456" } );
+      test.execute( Push { "789abc" } );
+      test.execute( BytesPushed { 10 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "0123456789" } );
+
+      test.execute( Pop { 8 } );
+      test.execute( PeekOnce { "89" } );
+      test.execute( Push { "defghijklmn" } );
+      test.execute( BytesBuffered { 10 } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "89defghijk" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked-pop-across-chunks", 20, ByteStream::Storage::Chunked };
+
+      test.execute( Push { "ab" } );
+      test.execute( Push { "cd" } );
+      test.execute( Push { "ef" } );
+      test.execute( Pop { 5 } );
+      test.execute( PeekOnce { "f" } );
+      test.execute( Pop { 100 } );
+      test.execute( BytesPopped { 6 } );
+      test.execute( BufferEmpty { true } );
+      test.execute( Push { "gh" } );
+      test.execute( PeekOnce { "gh" } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
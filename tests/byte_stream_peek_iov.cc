@@ -0,0 +1,96 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_iov-empty", 15 };
+      test.execute( PeekIov { {} } );
+      test.execute( Close {} );
+      test.execute( PeekIov { {} } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_iov-ring-wrap", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( PeekIov { { "abcdef" } } );
+      test.execute( Pop { 4 } );
+      test.execute( Push { "ghijk" } );
+
+      // the ring wraps after "gh", so the buffered bytes come back as two regions
+      test.execute( PeekIov { { "efgh", "ijk" } } );
+      test.execute( PeekIov { { "efgh" }, 1 } );
+      test.execute( PeekIov { {}, 0 } );
+      test.execute( Pop { 5 } );
+      test.execute( PeekIov { { "jk" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek-at-offset-ring", 8 };
+
+      test.execute( PeekAt { 0, "" } );
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 4 } );
+      test.execute( Push { "ghijk" } );
+      test.execute( PeekAt { 1, "fgh" } );
+      test.execute( PeekAt { 4, "ijk" } );
+      test.execute( PeekAt { 6, "k" } );
+      test.execute( PeekAt { 7, "" } );
+      test.execute( Peek { "efghijk" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek-at-offset-chunked", 20, ByteStream::Storage::Chunked };
+
+      test.execute( Push { "ab" } );
+      test.execute( Push { "cde" } );
+      test.execute( Push { "f" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAt { 0, "b" } );
+      test.execute( PeekAt { 1, "cde" } );
+      test.execute( PeekAt { 3, "e" } );
+      test.execute( PeekAt { 4, "f" } );
+      test.execute( PeekAt { 5, "" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_iov-chunked", 20, ByteStream::Storage::Chunked };
+
+      test.execute( Push { "ab" } );
+      test.execute( Push { "cde" } );
+      test.execute( Push { "f" } );
+      test.execute( Push { "ghij" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekIov { { "b", "cde", "f", "ghij" } } );
+      test.execute( PeekIov { { "b", "cde" }, 2 } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekIov { { "e", "f", "ghij" } } );
+    }
+
+    {
+      const string first( 4096, 'x' );
+      ByteStreamTestHarness test { "peek_iov-mirrored", first.size(), ByteStream::Storage::Mirrored };
+
+      test.execute( Push { first } );
+      test.execute( Pop { first.size() - 2 } );
+      test.execute( Push { "yz" } );
+      if ( test.storage() == ByteStream::Storage::Mirrored ) {
+        test.execute( PeekIov { { "xxyz" } } );
+      } else {
+        test.execute( PeekIov { { "xx", "yz" } } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+struct SlabsInUse : public ExpectNumber<ByteStream, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "[pool slabs in use]"; }
+  size_t value( ByteStream& ) const override { return BufferPool::global().stats().slabs_in_use; }
+};
+
+int main()
+{
+  try {
+    // tiny slabs, and few of them, so that streams span several slabs and can exhaust the pool
+    BufferPool::global().configure( 4, 6 );
+
+    {
+      ByteStreamTestHarness test { "pooled-basics", 15, ByteStream::Storage::Pooled };
+
+      test.execute( SlabsInUse { 0 } );
+      test.execute( Push { "cat" } );
+      test.execute( SlabsInUse { 1 } );
+      test.execute( Push { "tacocat" } );
+      test.execute( SlabsInUse { 3 } );
+      test.execute( BytesBuffered { 10 } );
+      test.execute( PeekOnce { "catt" } );
+      test.execute( PeekIov { { "catt", "acoc", "at" } } );
+
+      // slabs go back to the pool as soon as they are fully read
+      test.execute( Pop { 5 } );
+      test.execute( SlabsInUse { 2 } );
+      test.execute( PeekOnce { "coc" } );
+      test.execute( Push { "0123456789" } );
+      test.execute( BytesBuffered { 15 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekIov { { "coc", "at01", "2345", "6789" } } );
+      test.execute( PeekAt { 2, "c" } );
+      test.execute( PeekAt { 3, "at01" } );
+      test.execute( PeekAt { 8, "345" } );
+      test.execute( PeekAt { 15, "" } );
+      test.execute( SlabsInUse { 4 } );
+
+      // ... and all of them once the stream drains
+      test.execute( Close {} );
+      test.execute( ReadAll { "cocat0123456789" } );
+      test.execute( SlabsInUse { 0 } );
+      test.execute( IsFinished { true } );
+    }
+
+    test_should_be( BufferPool::global().stats().high_water_mark, size_t { 4 } );
+    test_should_be( BufferPool::global().stats().allocation_failures, uint64_t { 0 } );
+
+    {
+      ByteStreamTestHarness test { "pooled-exhausted", 40, ByteStream::Storage::Pooled };
+
+      // 6 pooled slabs hold 24 bytes; the rest comes from the heap but still works
+      test.execute( Push { "abcdefghijklmnopqrstuvwxyz0123456789" } );
+      test.execute( SlabsInUse { 6 } );
+      test.execute( BytesBuffered { 36 } );
+      test.execute( Pop { 30 } );
+      test.execute( SlabsInUse { 0 } ); // the last two slabs came from the heap
+      test.execute( PeekOnce { "45" } );
+      test.execute( Pop { 6 } );
+      test.execute( SlabsInUse { 0 } );
+    }
+
+    test_should_be( BufferPool::global().stats().high_water_mark, size_t { 6 } );
+    test_should_be( BufferPool::global().stats().allocation_failures, uint64_t { 3 } );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+#include "mapped_file.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <unistd.h>
+
+using namespace std;
+
+// Write `contents` to a fresh temporary file and map it.
+shared_ptr<const MappedFile> map_contents( const string& contents )
+{
+  string name = "/tmp/minnow_push_file_XXXXXX";
+  FileDescriptor file { CheckSystemCall( "mkstemp", mkstemp( name.data() ) ) };
+  CheckSystemCall( "unlink", unlink( name.c_str() ) );
+  if ( not contents.empty() ) {
+    file.write( contents );
+  }
+  return make_shared<const MappedFile>( file );
+}
+
+struct PushFile : public Action<ByteStream>
+{
+  shared_ptr<const MappedFile> file_;
+  uint64_t offset_;
+  uint64_t expected_;
+
+  PushFile( shared_ptr<const MappedFile> file, uint64_t offset, uint64_t expected )
+    : file_( move( file ) ), offset_( offset ), expected_( expected )
+  {}
+
+  std::string description() const override
+  {
+    return "push_file from offset " + to_string( offset_ ) + " of a " + to_string( file_->size() ) + "-byte file";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto pushed = bs.writer().push_file( file_, offset_ );
+    if ( pushed != expected_ ) {
+      throw ExpectationViolation { "push_file", expected_, pushed };
+    }
+  }
+};
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring,
+                                 ByteStream::Storage::Mirrored,
+                                 ByteStream::Storage::Chunked,
+                                 ByteStream::Storage::Pooled } ) {
+      {
+        ByteStreamTestHarness test { "push_file-basic", 8, storage };
+        const auto file = map_contents( "0123456789" );
+
+        // only as much as the free space allows
+        test.execute( PushFile { file, 0, 8 } );
+        test.execute( AvailableCapacity { 0 } );
+        test.execute( PushFile { file, 8, 0 } );
+        test.execute( Pop { 3 } );
+        test.execute( PushFile { file, 8, 2 } );
+        test.execute( BytesPushed { 10 } );
+        test.execute( Close {} );
+        test.execute( ReadAll { "3456789" } );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        ByteStreamTestHarness test { "push_file-mixed", 20, storage };
+        const auto file = map_contents( "hello, world" );
+
+        test.execute( Push { "<" } );
+        test.execute( PushFile { file, 7, 5 } );
+        test.execute( Push { ">" } );
+        test.execute( PushFile { file, 12, 0 } );
+        test.execute( PushFile { file, 100, 0 } );
+        test.execute( BytesBuffered { 7 } );
+        test.execute( ReadAll { "<world>" } );
+      }
+
+      {
+        ByteStreamTestHarness test { "push_file-empty", 8, storage };
+        test.execute( PushFile { map_contents( "" ), 0, 0 } );
+        test.execute( BytesPushed { 0 } );
+      }
+    }
+
+    {
+      // Chunked storage keeps the slice of the mapping, so peek() points into the mapped pages
+      ByteStream stream { 100, ByteStream::Storage::Chunked };
+      const auto file = map_contents( "mapped bytes" );
+      stream.writer().push_file( file, 7 );
+      if ( stream.reader().peek().data() != file->view().data() + 7 ) {
+        throw runtime_error( "Chunked push_file copied the mapped bytes" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+// Write `data_` into a fresh pipe (optionally closing it), then have the stream read from the pipe.
+struct PushFromFd : public Action<ByteStream>
+{
+  std::string data_;
+  size_t expected_read_;
+  bool close_ {};
+
+  PushFromFd( std::string data, size_t expected_read, bool close = false )
+    : data_( move( data ) ), expected_read_( expected_read ), close_( close )
+  {}
+
+  std::string description() const override
+  {
+    return "push_from_fd with \"" + Printer::prettify( data_ ) + "\" in the pipe" + ( close_ ? " (then EOF)" : "" );
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    array<int, 2> fds {};
+    CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+    FileDescriptor read_end { fds[0] };
+    FileDescriptor write_end { fds[1] };
+    if ( not data_.empty() ) {
+      write_end.write( data_ );
+    }
+    if ( close_ ) {
+      write_end.close();
+    }
+
+    const auto bytes_read = bs.writer().push_from_fd( read_end );
+    if ( bytes_read != expected_read_ ) {
+      throw ExpectationViolation { "push_from_fd", expected_read_, bytes_read };
+    }
+    if ( close_ and data_.empty() and not read_end.eof() ) {
+      throw ExpectationViolation { "push_from_fd should have seen EOF on an empty, closed pipe" };
+    }
+  }
+};
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring,
+                                 ByteStream::Storage::Mirrored,
+                                 ByteStream::Storage::Chunked,
+                                 ByteStream::Storage::Pooled } ) {
+      {
+        ByteStreamTestHarness test { "push_from_fd-basic", 8, storage };
+
+        test.execute( PushFromFd { "abcdef", 6 } );
+        test.execute( BytesPushed { 6 } );
+        test.execute( AvailableCapacity { 2 } );
+        test.execute( Peek { "abcdef" } );
+
+        // only as much as the free space allows
+        test.execute( PushFromFd { "ghijk", 2 } );
+        test.execute( AvailableCapacity { 0 } );
+        test.execute( PushFromFd { "xyz", 0 } );
+        test.execute( Peek { "abcdefgh" } );
+      }
+
+      {
+        ByteStreamTestHarness test { "push_from_fd-wrap", 8, storage };
+
+        test.execute( Push { "abcdef" } );
+        test.execute( Pop { 5 } );
+        test.execute( PushFromFd { "ghijklm", 7 } );
+        test.execute( BytesBuffered { 8 } );
+        test.execute( Close {} );
+        test.execute( ReadAll { "fghijklm" } );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        ByteStreamTestHarness test { "push_from_fd-eof", 8, storage };
+
+        test.execute( PushFromFd { "ab", 2, true } );
+        test.execute( PushFromFd { "", 0, true } );
+        test.execute( BytesPushed { 2 } );
+        test.execute( Peek { "ab" } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
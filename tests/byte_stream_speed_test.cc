@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
 
 #include <chrono>
 #include <cstddef>
@@ -15,7 +16,8 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   // Generate the data to be written
   const string data = [&random_seed, &input_len] {
@@ -34,7 +36,7 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
     split_data.emplace( data.substr( i, write_size ) );
   }
 
-  ByteStream bs { capacity };
+  ByteStream bs { capacity, storage };
   string output_data;
   output_data.reserve( data.size() );
 
@@ -75,10 +77,12 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  cout << "ByteStream (" << storage_name( bs.storage() ) << ") with capacity=" << capacity
+       << ", write_size=" << write_size << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 )
+       << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "             ByteStream throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+  debug_output << "             ByteStream throughput (" << storage_name( bs.storage() )
+               << ", write_size=" << write_size << "): " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
@@ -89,6 +93,17 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
 void program_body()
 {
   speed_test( 1e7, 32768, 789, 1500, 128 );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Chunked );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Pooled );
+
+  // Large writes, where adopting the pushed strings saves copying them into the stream
+  for ( const auto storage : { ByteStream::Storage::Ring,
+                               ByteStream::Storage::Mirrored,
+                               ByteStream::Storage::Chunked,
+                               ByteStream::Storage::Pooled } ) {
+    speed_test( 4e7, 1 << 20, 789, 1 << 16, 1 << 16, storage );
+    speed_test( 4e7, 1 << 22, 789, 1 << 20, 1 << 20, storage );
+  }
 }
 
 int main()
@@ -6,6 +6,7 @@
 #include <concepts>
 #include <optional>
 #include <utility>
+#include <vector>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Reader." );
@@ -13,6 +14,21 @@ static_assert( sizeof( Reader ) == sizeof( ByteStream ),
 static_assert( sizeof( Writer ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Writer." );
 
+inline std::string storage_name( ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::Ring:
+      return "ring";
+    case ByteStream::Storage::Mirrored:
+      return "mirrored";
+    case ByteStream::Storage::Chunked:
+      return "chunked";
+    case ByteStream::Storage::Pooled:
+      return "pooled";
+  }
+  return "unknown";
+}
+
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
@@ -20,7 +36,14 @@ public:
     : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
   {}
 
+  ByteStreamTestHarness( std::string test_name, uint64_t capacity, ByteStream::Storage storage )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", storage=" + storage_name( storage ),
+                   ByteStream { capacity, storage } )
+  {}
+
   size_t peek_size() { return object().reader().peek().size(); }
+  ByteStream::Storage storage() const { return object().storage(); }
 };
 
 /* actions */
@@ -107,6 +130,63 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAt : public Expectation<ByteStream>
+{
+  uint64_t offset_;
+  std::string output_;
+
+  PeekAt( uint64_t offset, std::string output ) : offset_( offset ), output_( move( output ) ) {}
+
+  std::string description() const override
+  {
+    return "peek( " + std::to_string( offset_ ) + " ) gives \"" + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto got = bs.reader().peek( offset_ );
+    if ( got != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\", but got \""
+                                   + Printer::prettify( std::string( got ) ) + "\"" };
+    }
+  }
+};
+
+struct PeekIov : public Expectation<ByteStream>
+{
+  std::vector<std::string> regions_;
+  size_t max_regions_;
+
+  explicit PeekIov( std::vector<std::string> regions, size_t max_regions = 16 )
+    : regions_( move( regions ) ), max_regions_( max_regions )
+  {}
+
+  std::string description() const override
+  {
+    std::string ret = "peek_iov( " + std::to_string( max_regions_ ) + " ) gives {";
+    for ( const auto& x : regions_ ) {
+      ret += " \"" + Printer::prettify( x ) + "\"";
+    }
+    return ret + " }";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto got = bs.reader().peek_iov( max_regions_ );
+    if ( got.size() != regions_.size() ) {
+      throw ExpectationViolation { "Expected " + std::to_string( regions_.size() ) + " regions, but got "
+                                   + std::to_string( got.size() ) };
+    }
+    for ( size_t i = 0; i < got.size(); ++i ) {
+      if ( got[i] != regions_[i] ) {
+        throw ExpectationViolation { "Expected region " + std::to_string( i ) + " to be \""
+                                     + Printer::prettify( regions_[i] ) + "\", but found \""
+                                     + Printer::prettify( got[i] ) + "\"" };
+      }
+    }
+  }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream>
 {
   using ConstExpectBool::ConstExpectBool;
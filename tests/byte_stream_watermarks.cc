@@ -0,0 +1,135 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+
+// Install both watermark callbacks, each counting its calls into a shared counter.
+struct Watch : public Action<ByteStream>
+{
+  uint64_t low_mark_;
+  uint64_t threshold_;
+  shared_ptr<uint64_t> capacity_calls_;
+  shared_ptr<uint64_t> buffered_calls_;
+
+  Watch( uint64_t low_mark,
+         uint64_t threshold,
+         shared_ptr<uint64_t> capacity_calls,
+         shared_ptr<uint64_t> buffered_calls )
+    : low_mark_( low_mark )
+    , threshold_( threshold )
+    , capacity_calls_( move( capacity_calls ) )
+    , buffered_calls_( move( buffered_calls ) )
+  {}
+
+  std::string description() const override
+  {
+    return "watch capacity above " + to_string( low_mark_ ) + " and buffered above " + to_string( threshold_ );
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    bs.writer().on_capacity_above( low_mark_, [calls = capacity_calls_] { ++*calls; } );
+    bs.reader().on_buffered_above( threshold_, [calls = buffered_calls_] { ++*calls; } );
+  }
+};
+
+struct Calls : public Expectation<ByteStream>
+{
+  string name_;
+  shared_ptr<uint64_t> calls_;
+  uint64_t expected_;
+
+  Calls( string name, shared_ptr<uint64_t> calls, uint64_t expected )
+    : name_( move( name ) ), calls_( move( calls ) ), expected_( expected )
+  {}
+
+  std::string description() const override { return name_ + " callback ran " + to_string( expected_ ) + " times"; }
+
+  void execute( ByteStream& /* unused */ ) const override
+  {
+    if ( *calls_ != expected_ ) {
+      throw ExpectationViolation { name_ + " callbacks", expected_, *calls_ };
+    }
+  }
+};
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring,
+                                 ByteStream::Storage::Mirrored,
+                                 ByteStream::Storage::Chunked,
+                                 ByteStream::Storage::Pooled } ) {
+      {
+        ByteStreamTestHarness test { "watermarks-edges", 10, storage };
+        auto capacity = make_shared<uint64_t>( 0 );
+        auto buffered = make_shared<uint64_t>( 0 );
+        test.execute( Watch { 4, 3, capacity, buffered } );
+
+        // rising to the threshold fires once; staying above it does not fire again
+        test.execute( Push { "ab" } );
+        test.execute( Calls { "buffered", buffered, 0 } );
+        test.execute( Push { "c" } );
+        test.execute( Calls { "buffered", buffered, 1 } );
+        test.execute( Push { "defgh" } );
+        test.execute( Calls { "buffered", buffered, 1 } );
+
+        // capacity is 2; popping to 3 stays below the low mark, popping to 5 crosses it
+        test.execute( Calls { "capacity", capacity, 0 } );
+        test.execute( Pop { 1 } );
+        test.execute( Calls { "capacity", capacity, 0 } );
+        test.execute( Pop { 2 } );
+        test.execute( Calls { "capacity", capacity, 1 } );
+        test.execute( Pop { 5 } );
+        test.execute( Calls { "capacity", capacity, 1 } );
+
+        // the stream is empty again, so the next rise fires again
+        test.execute( Push { "0123456789" } );
+        test.execute( Calls { "buffered", buffered, 2 } );
+        test.execute( BytesBuffered { 10 } );
+        test.execute( Pop { 10 } );
+        test.execute( Calls { "capacity", capacity, 2 } );
+
+        // closing is not an edge
+        test.execute( Close {} );
+        test.execute( Calls { "buffered", buffered, 2 } );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        // marks above the capacity are clamped to it
+        ByteStreamTestHarness test { "watermarks-clamped", 4, storage };
+        auto capacity = make_shared<uint64_t>( 0 );
+        auto buffered = make_shared<uint64_t>( 0 );
+        test.execute( Watch { 100, 100, capacity, buffered } );
+        test.execute( Push { "abcdef" } );
+        test.execute( Calls { "buffered", buffered, 1 } );
+        test.execute( Pop { 3 } );
+        test.execute( Calls { "capacity", capacity, 0 } );
+        test.execute( Pop { 1 } );
+        test.execute( Calls { "capacity", capacity, 1 } );
+      }
+
+      {
+        // a zero mark never fires
+        ByteStreamTestHarness test { "watermarks-off", 4, storage };
+        auto capacity = make_shared<uint64_t>( 0 );
+        auto buffered = make_shared<uint64_t>( 0 );
+        test.execute( Watch { 0, 0, capacity, buffered } );
+        test.execute( Push { "abcd" } );
+        test.execute( Pop { 4 } );
+        test.execute( Calls { "buffered", buffered, 0 } );
+        test.execute( Calls { "capacity", capacity, 0 } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
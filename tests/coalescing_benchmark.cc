@@ -0,0 +1,159 @@
+#include "benchmark.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// An application that writes short records, in bursts, over a path with a 20 ms round trip
+constexpr uint64_t ONE_WAY_DELAY = 10'000; // microseconds
+constexpr uint64_t STEP = 10;              // microseconds per tick
+constexpr uint64_t RECORD_SIZE = 20;
+constexpr uint64_t RECORDS = 5000;
+constexpr uint64_t HEADER_SIZE = 40; // IPv4 and TCP, without options
+constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+struct Result
+{
+  string coalescing {};
+  uint64_t interval {}; // microseconds between bursts
+  uint64_t burst {};    // records written back to back (each with a write of its own)
+  uint64_t segments {};
+  uint64_t bytes {};
+  double mean_latency_ms {}; // from a record's write to its arrival in the receiver's stream
+  double max_latency_ms {};
+
+  double segments_per_kilobyte() const
+  {
+    return 1000 * static_cast<double>( segments ) / static_cast<double>( bytes );
+  }
+  double header_overhead() const
+  {
+    return static_cast<double>( HEADER_SIZE * segments ) / static_cast<double>( bytes );
+  }
+};
+
+Result run( Coalescing coalescing, const string& name, uint64_t interval, uint64_t burst )
+{
+  const Wrap32 isn { 1370 };
+  TCPSender sender { ByteStream { TCPConfig::DEFAULT_CAPACITY },
+                     isn,
+                     TCPConfig::TIMEOUT_DFLT,
+                     CongestionControl::make( CongestionControl::Algorithm::NewReno, MSS ),
+                     TCPSender::RTOBounds { 200'000, 60'000'000 },
+                     coalescing };
+  TCPReceiver receiver { Reassembler { ByteStream { TCPConfig::DEFAULT_CAPACITY } } };
+
+  deque<InFlight<TCPSenderMessage>> downlink;
+  deque<InFlight<TCPReceiverMessage>> uplink;
+
+  Result result { .coalescing = name, .interval = interval, .burst = burst };
+  uint64_t now = 0;
+  const auto transmit = [&]( const TCPSenderMessage& msg ) {
+    if ( not msg.payload.empty() ) {
+      ++result.segments;
+      result.bytes += msg.payload.size();
+    }
+    downlink.push_back( { now + ONE_WAY_DELAY, msg } );
+  };
+
+  // connect first, so the records don't wait behind the handshake
+  sender.push( transmit );
+  vector<uint64_t> written_at;
+  uint64_t bytes_read = 0;
+  uint64_t total_latency = 0;
+  uint64_t max_latency = 0;
+  while ( bytes_read < RECORDS * RECORD_SIZE ) {
+    // the application writes each record as its own write, and the socket pushes after each
+    while ( written_at.size() < RECORDS and now >= ONE_WAY_DELAY * 2 + written_at.size() / burst * interval
+            and sender.writer().available_capacity() >= RECORD_SIZE ) {
+      sender.writer().push( string( RECORD_SIZE, 'r' ) );
+      written_at.push_back( now );
+      sender.push( transmit );
+    }
+
+    // like the socket's event loop: the tick itself releases corked bytes
+    now += STEP;
+    sender.tick_us( STEP, transmit );
+
+    while ( not downlink.empty() and downlink.front().arrival <= now ) {
+      receiver.receive( std::move( downlink.front().msg ) );
+      downlink.pop_front();
+      uplink.push_back( { now + ONE_WAY_DELAY, receiver.send() } );
+    }
+    const uint64_t first_record = bytes_read / RECORD_SIZE;
+    bytes_read += receiver.reader().bytes_buffered();
+    receiver.reader().pop( receiver.reader().bytes_buffered() );
+    for ( uint64_t i = first_record; i < bytes_read / RECORD_SIZE; ++i ) {
+      total_latency += now - written_at.at( i );
+      max_latency = max( max_latency, now - written_at.at( i ) );
+    }
+
+    while ( not uplink.empty() and uplink.front().arrival <= now ) {
+      sender.receive( uplink.front().msg );
+      uplink.pop_front();
+      sender.push( transmit );
+    }
+  }
+
+  result.mean_latency_ms = static_cast<double>( total_latency ) / RECORDS / 1e3;
+  result.max_latency_ms = static_cast<double>( max_latency ) / 1e3;
+  return result;
+}
+
+void print( const vector<Result>& results, const Format format )
+{
+  const vector<Column> columns { { "mode", "mode", 10 },
+                                 { "interval_us", "interval us", 12 },
+                                 { "burst", "burst", 7 },
+                                 { "segments", "segments", 10 },
+                                 { "bytes", "" },
+                                 { "segments_per_kb", "segs per KB", 12 },
+                                 { "header_overhead_percent", "headers %", 10 },
+                                 { "mean_latency_ms", "mean lat ms", 14 },
+                                 { "max_latency_ms", "max lat ms", 13 } };
+  vector<Row> rows;
+  for ( const auto& r : results ) {
+    rows.push_back( { r.coalescing,
+                      r.interval,
+                      r.burst,
+                      r.segments,
+                      r.bytes,
+                      r.segments_per_kilobyte(),
+                      100 * r.header_overhead(),
+                      r.mean_latency_ms,
+                      r.max_latency_ms } );
+  }
+  ::print( columns, rows, format );
+}
+
+void program_body( const Format format )
+{
+  vector<Result> results;
+  const vector<pair<uint64_t, uint64_t>> workloads { { 10, 1 }, { 100, 1 }, { 1000, 1 }, { 1000, 10 } };
+  const vector<pair<Coalescing, string>> modes {
+    { Coalescing::Off, "nodelay" }, { Coalescing::Nagle, "nagle" }, { Coalescing::Autocork, "autocork" } };
+  for ( const auto& [interval, burst] : workloads ) {
+    for ( const auto& [coalescing, name] : modes ) {
+      results.push_back( run( coalescing, name, interval, burst ) );
+    }
+  }
+
+  print( results, format );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return benchmark_main( argc, argv, program_body );
+}
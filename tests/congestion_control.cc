@@ -0,0 +1,191 @@
+#include "congestion_control.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t MSS = 1000;
+constexpr uint64_t RTT = 100'000; // microseconds
+
+// Ack `bytes` in one-segment acks spread over one round trip, as a path with no queue would
+uint64_t ack_round( CongestionControl& cc, uint64_t now, uint64_t bytes, uint64_t& delivered )
+{
+  const uint64_t prior_delivered = delivered;
+  const uint64_t acks = bytes / MSS;
+  for ( uint64_t i = 0; i < acks; ++i ) {
+    delivered += MSS;
+    now += RTT / acks;
+    cc.on_ack( { .now = now,
+                 .bytes_acked = MSS,
+                 .bytes_in_flight = bytes - ( i + 1 ) * MSS,
+                 .rtt = RTT,
+                 .delivered = delivered,
+                 .prior_delivered = prior_delivered,
+                 .delivery_rate = bytes * 1'000'000 / RTT } );
+  }
+  return now;
+}
+
+void test_make()
+{
+  test_should_be( CongestionControl::make( CongestionControl::Algorithm::None, MSS ) == nullptr, true );
+  for ( const auto& [algorithm, name] : { pair { CongestionControl::Algorithm::NewReno, "newreno"s },
+                                          pair { CongestionControl::Algorithm::CUBIC, "cubic"s },
+                                          pair { CongestionControl::Algorithm::BBR, "bbr"s } } ) {
+    const string made { CongestionControl::make( algorithm, MSS )->name() };
+    if ( made != name ) {
+      throw runtime_error( "Expected to make \"" + name + "\", but made \"" + made + "\"" );
+    }
+  }
+}
+
+void test_newreno()
+{
+  NewReno cc { MSS };
+  uint64_t delivered = 0;
+  test_should_be( cc.cwnd(), 10 * MSS ); // initial window of ten segments
+
+  // slow start doubles the window every round trip
+  uint64_t now = ack_round( cc, 0, cc.cwnd(), delivered );
+  test_should_be( cc.cwnd(), 20 * MSS );
+
+  // a loss halves what was in flight
+  cc.on_loss( now, 20 * MSS );
+  test_should_be( cc.cwnd(), 10 * MSS );
+  test_should_be( cc.ssthresh(), 10 * MSS );
+
+  // acks during recovery don't grow it
+  cc.on_ack( { .now = now, .bytes_acked = MSS, .in_recovery = true } );
+  test_should_be( cc.cwnd(), 10 * MSS );
+
+  // congestion avoidance: one segment per round trip
+  now = ack_round( cc, now, cc.cwnd(), delivered );
+  test_should_be( cc.cwnd(), 11 * MSS ); // one more segment after a window of acks
+  now = ack_round( cc, now, 5 * MSS, delivered );
+  test_should_be( cc.cwnd(), 11 * MSS ); // but not after half a window
+
+  cc.on_timeout( now, 11 * MSS );
+  test_should_be( cc.cwnd(), MSS ); // timeout leaves one segment
+  test_should_be( cc.ssthresh(), uint64_t { 5500 } );
+
+  // never below two segments
+  cc.on_loss( now, MSS );
+  test_should_be( cc.ssthresh(), 2 * MSS );
+}
+
+void test_cubic()
+{
+  Cubic cc { MSS };
+  uint64_t delivered = 0;
+  uint64_t now = ack_round( cc, 0, cc.cwnd(), delivered );
+  test_should_be( cc.cwnd(), 20 * MSS ); // slow start doubled the window
+
+  cc.on_loss( now, cc.cwnd() );
+  test_should_be( cc.cwnd(), 14 * MSS ); // loss kept 70% of the window
+
+  // grows back toward the window where the loss happened, then past it
+  uint64_t rounds_to_recover = 0;
+  while ( cc.cwnd() < 20 * MSS and rounds_to_recover < 1000 ) {
+    const uint64_t before = cc.cwnd();
+    now = ack_round( cc, now, cc.cwnd(), delivered );
+    if ( cc.cwnd() < before ) {
+      throw runtime_error( "Expected the window never to shrink on acks" );
+    }
+    ++rounds_to_recover;
+  }
+  if ( rounds_to_recover <= 1 or rounds_to_recover >= 40 ) {
+    throw runtime_error( "Expected to recover within a few seconds, but took " + to_string( rounds_to_recover )
+                         + " round trips" );
+  }
+  for ( unsigned i = 0; i < 40; ++i ) {
+    now = ack_round( cc, now, cc.cwnd(), delivered );
+  }
+  if ( cc.cwnd() <= 30 * MSS ) {
+    throw runtime_error( "Expected to probe well past the old window, but cwnd is " + to_string( cc.cwnd() ) );
+  }
+
+  const uint64_t before = cc.cwnd();
+  cc.on_loss( now, before );
+  if ( cc.cwnd() + 1 < before * 7 / 10 or cc.cwnd() > before * 7 / 10 + 1 ) {
+    throw runtime_error( "Expected the loss to keep 70% of " + to_string( before ) + ", but cwnd is "
+                         + to_string( cc.cwnd() ) );
+  }
+
+  cc.on_timeout( now, cc.cwnd() );
+  test_should_be( cc.cwnd(), MSS );
+}
+
+void test_bbr()
+{
+  BBR cc { MSS };
+  uint64_t delivered = 0;
+  uint64_t now = 0;
+
+  // a path that delivers a BDP of 100 segments no matter how much is sent
+  const uint64_t bdp = 100 * MSS;
+  now = ack_round( cc, now, bdp, delivered );
+  test_should_be( cc.mode() == BBR::Mode::Startup, true );
+  test_should_be( cc.bandwidth(), bdp * 1'000'000 / RTT );
+  test_should_be( cc.min_rtt(), RTT );
+  if ( cc.pacing_rate() <= 2 * cc.bandwidth() ) {
+    throw runtime_error( "Expected to pace at a high gain in Startup, but paced at " + to_string( cc.pacing_rate() ) );
+  }
+
+  // the bandwidth stops growing: the pipe is full, drain the queue, then cruise
+  for ( unsigned i = 0; i < 5; ++i ) {
+    now = ack_round( cc, now, bdp, delivered );
+  }
+  test_should_be( cc.mode() == BBR::Mode::ProbeBW, true );
+  for ( unsigned i = 0; i < 30; ++i ) {
+    now = ack_round( cc, now, bdp, delivered );
+    if ( cc.pacing_rate() < cc.bandwidth() * 3 / 4 or cc.pacing_rate() > cc.bandwidth() * 5 / 4 ) {
+      throw runtime_error( "Expected the pacing gain to cycle around 1, but paced at " + to_string( cc.pacing_rate() )
+                           + " for a bandwidth of " + to_string( cc.bandwidth() ) );
+    }
+  }
+  test_should_be( cc.cwnd(), 2 * bdp ); // two BDPs in ProbeBW
+
+  // loss doesn't change the model; a timeout restarts from one segment
+  cc.on_loss( now, bdp );
+  test_should_be( cc.cwnd(), 2 * bdp );
+
+  // without a new minimum for ten seconds, remeasure it with a small window
+  cc.on_ack( { .now = now + 10'000'001,
+               .bytes_acked = MSS,
+               .bytes_in_flight = bdp,
+               .rtt = 2 * RTT,
+               .delivered = delivered + MSS,
+               .prior_delivered = delivered } );
+  test_should_be( cc.mode() == BBR::Mode::ProbeRTT, true );
+  test_should_be( cc.cwnd(), 4 * MSS );
+  test_should_be( cc.min_rtt(), 2 * RTT ); // the stale minimum expired
+
+  cc.on_timeout( now, bdp );
+  test_should_be( cc.cwnd(), MSS );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    test_make();
+    test_newreno();
+    test_cubic();
+    test_bbr();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "tcp_receiver_message.hh"
 #include "wrapping_integers.hh"
 
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 // https://stackoverflow.com/questions/33399594/making-a-user-defined-class-stdto-stringable
 
@@ -31,6 +33,21 @@ std::string to_string( const std::optional<T>& v )
 
   return "None";
 }
+
+inline std::string to_string( const SACKBlock& block )
+{
+  return "[" + to_string( block.left ) + ", " + to_string( block.right ) + ")";
+}
+
+template<typename T>
+std::string to_string( const std::vector<T>& v )
+{
+  std::string ret = "{";
+  for ( const auto& x : v ) {
+    ret += ( ret.size() > 1 ? ", " : " " ) + to_string( x );
+  }
+  return ret + " }";
+}
 } // namespace minnow_conversions
 
 template<typename T>
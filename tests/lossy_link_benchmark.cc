@@ -0,0 +1,195 @@
+#include "benchmark.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// A path of 20 Mbit/s with a 20 ms round trip, which drops data segments at random
+constexpr uint64_t BANDWIDTH = 20'000'000;   // bits per second
+constexpr uint64_t ONE_WAY_DELAY = 10'000;   // microseconds
+constexpr uint64_t STEP = 100;               // microseconds per tick
+constexpr uint64_t TIME_LIMIT = 300'000'000; // microseconds
+constexpr uint64_t STREAM_LENGTH = 4'000'000;
+constexpr uint64_t MSS = 1000;
+
+// What the sender gets to see of the receiver's acks
+enum class Recovery : uint8_t
+{
+  RTOOnly, // only acks that advance, without SACK blocks: every loss waits for the timer
+  DupAck,  // every ack, without SACK blocks: fast retransmit and limited transmit
+  SACK,    // every ack, with SACK blocks
+};
+
+struct Result
+{
+  string recovery {};
+  double loss_rate {};
+  double simulated_seconds {};
+  double wall_seconds {};
+  uint64_t segments_sent {};
+  uint64_t segments_lost {};
+  uint64_t timeouts {};
+  double ms_per_loss {}; // time added to the transfer by each loss, against the lossless run
+
+  double goodput_mbit_per_second() const
+  {
+    return 8 * static_cast<double>( STREAM_LENGTH ) / simulated_seconds / 1e6;
+  }
+};
+
+Result run( const string& data, Recovery recovery, const string& name, double loss_rate )
+{
+  const Wrap32 isn { 1370 };
+  TCPSender sender { ByteStream { 4 * TCPConfig::DEFAULT_CAPACITY },
+                     isn,
+                     TCPConfig::TIMEOUT_DFLT,
+                     CongestionControl::make( CongestionControl::Algorithm::NewReno, MSS ),
+                     TCPSender::RTOBounds { 200'000, 60'000'000 } };
+  TCPReceiver receiver { Reassembler { ByteStream { TCPConfig::DEFAULT_CAPACITY } } };
+
+  deque<InFlight<TCPSenderMessage>> downlink;
+  deque<InFlight<TCPReceiverMessage>> uplink;
+  default_random_engine rd { 1370 };
+  bernoulli_distribution lose { loss_rate };
+
+  Result result { .recovery = name, .loss_rate = loss_rate };
+  uint64_t now = 0;
+  uint64_t link_free_at = 0;
+  const auto transmit = [&]( const TCPSenderMessage& msg ) {
+    ++result.segments_sent;
+    if ( not msg.payload.empty() and lose( rd ) ) {
+      ++result.segments_lost;
+      return;
+    }
+    link_free_at = max( link_free_at, now ) + msg.payload.size() * 8 * 1'000'000 / BANDWIDTH;
+    downlink.push_back( { link_free_at + ONE_WAY_DELAY, msg } );
+  };
+
+  uint64_t highest_ackno = 0;
+  uint64_t written = 0;
+  uint64_t bytes_read = 0;
+  uint64_t retransmissions = 0;
+  const auto start_time = steady_clock::now();
+  while ( not receiver.reader().is_finished() and now < TIME_LIMIT ) {
+    if ( written < data.size() ) {
+      const uint64_t length = min( sender.writer().available_capacity(), data.size() - written );
+      sender.writer().push( data.substr( written, length ) );
+      written += length;
+      if ( written == data.size() ) {
+        sender.writer().close();
+      }
+    }
+    sender.push( transmit );
+
+    now += STEP;
+    sender.tick_us( STEP, transmit );
+    if ( sender.consecutive_retransmissions() > retransmissions ) {
+      ++result.timeouts;
+    }
+    retransmissions = sender.consecutive_retransmissions();
+
+    while ( not downlink.empty() and downlink.front().arrival <= now ) {
+      receiver.receive( std::move( downlink.front().msg ) );
+      downlink.pop_front();
+      uplink.push_back( { now + ONE_WAY_DELAY, receiver.send() } );
+    }
+    bytes_read += receiver.reader().bytes_buffered();
+    receiver.reader().pop( receiver.reader().bytes_buffered() );
+
+    while ( not uplink.empty() and uplink.front().arrival <= now ) {
+      TCPReceiverMessage& ack = uplink.front().msg;
+      if ( recovery != Recovery::SACK ) {
+        ack.sack.clear();
+      }
+      const uint64_t ackno = ack.ackno.has_value() ? ack.ackno->unwrap( isn, highest_ackno ) : 0;
+      if ( recovery != Recovery::RTOOnly or ackno > highest_ackno ) {
+        sender.receive( ack );
+      }
+      highest_ackno = max( highest_ackno, ackno );
+      uplink.pop_front();
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( bytes_read != data.size() ) {
+    throw runtime_error( "transfer didn't finish (" + result.recovery + ")" );
+  }
+  result.simulated_seconds = static_cast<double>( now ) / 1e6;
+  result.wall_seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  return result;
+}
+
+void print( const vector<Result>& results, const Format format )
+{
+  const vector<Column> columns { { "recovery", "recovery", 10 },
+                                 { "loss_rate", "loss", 6, 3 },
+                                 { "simulated_seconds", "simulated s", 12 },
+                                 { "wall_seconds", "" },
+                                 { "goodput_mbit_per_s", "Mbit/s", 10 },
+                                 { "segments_sent", "sent", 10 },
+                                 { "segments_lost", "lost", 8 },
+                                 { "timeouts", "timeouts", 10 },
+                                 { "ms_per_loss", "ms per loss", 12, 1 } };
+  vector<Row> rows;
+  for ( const auto& r : results ) {
+    rows.push_back( { r.recovery,
+                      r.loss_rate,
+                      r.simulated_seconds,
+                      r.wall_seconds,
+                      r.goodput_mbit_per_second(),
+                      r.segments_sent,
+                      r.segments_lost,
+                      r.timeouts,
+                      r.ms_per_loss } );
+  }
+  ::print( columns, rows, format );
+}
+
+void program_body( const Format format )
+{
+  const string data = [] {
+    mt19937_64 rd { STREAM_LENGTH };
+    string ret( STREAM_LENGTH, 0 );
+    for ( auto& c : ret ) {
+      c = static_cast<char>( rd() );
+    }
+    return ret;
+  }();
+
+  vector<Result> results;
+  const vector<pair<Recovery, string>> recoveries {
+    { Recovery::RTOOnly, "rto_only" }, { Recovery::DupAck, "dupack" }, { Recovery::SACK, "sack" } };
+  for ( const auto& [recovery, name] : recoveries ) {
+    const Result lossless = run( data, recovery, name, 0 );
+    results.push_back( lossless );
+    for ( const double loss_rate : { 0.005, 0.01, 0.02, 0.05 } ) {
+      Result r = run( data, recovery, name, loss_rate );
+      r.ms_per_loss
+        = ( r.simulated_seconds - lossless.simulated_seconds ) * 1e3 / static_cast<double>( r.segments_lost );
+      results.push_back( r );
+    }
+  }
+
+  print( results, format );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return benchmark_main( argc, argv, program_body );
+}
@@ -21,12 +21,14 @@ EthernetAddress random_private_ethernet_address()
   return addr;
 }
 
-InternetDatagram make_datagram( const string& src_ip, const string& dst_ip ) // NOLINT(*-swappable-*)
+InternetDatagram make_datagram( const string& src_ip, // NOLINT(*-swappable-*)
+                                const string& dst_ip,
+                                const string& payload = "hello" )
 {
   InternetDatagram dgram;
   dgram.header.src = Address( src_ip, 0 ).ipv4_numeric();
   dgram.header.dst = Address( dst_ip, 0 ).ipv4_numeric();
-  dgram.payload.emplace_back( "hello" );
+  dgram.payload.emplace_back( payload );
   dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.front().size();
   dgram.header.compute_checksum();
   return dgram;
@@ -56,7 +58,7 @@ EthernetFrame make_frame( const EthernetAddress& src,
   frame.header.src = src;
   frame.header.dst = dst;
   frame.header.type = type;
-  frame.payload = std::move( payload );
+  frame.payload = to_slices( std::move( payload ) );
   return frame;
 }
 
@@ -320,6 +322,42 @@ int main()
         serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
       test.execute( ExpectNoFrame {} );
     }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress target_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "datagrams larger than the MTU are dropped", local_eth, Address( "4.3.2.1", 0 ), 9000 };
+
+      test.execute( ReceiveFrame {
+        make_frame(
+          target_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, target_eth, "192.168.0.1", local_eth, "4.3.2.1" ) ) ),
+        {} } );
+
+      // a jumbo frame fits
+      const auto jumbo = make_datagram( "5.6.7.8", "13.12.11.10", string( 8980, 'j' ) );
+      test.execute( SendDatagram { jumbo, Address( "192.168.0.1", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, target_eth, EthernetHeader::TYPE_IPv4, serialize( jumbo ) ) } );
+
+      // one byte more doesn't
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10", string( 8981, 'j' ) ),
+                                   Address( "192.168.0.1", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "the default MTU is 1500", local_eth, Address( "4.3.2.1", 0 ) };
+
+      // dropped before any ARP request
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10", string( 1481, 'x' ) ),
+                                   Address( "192.168.0.1", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
@@ -23,10 +23,11 @@ class NetworkInterfaceTestHarness : public TestHarness<InterfaceAndOutput>
 public:
   NetworkInterfaceTestHarness( std::string test_name,
                                const EthernetAddress& ethernet_address,
-                               const Address& ip_address )
+                               const Address& ip_address,
+                               size_t mtu = NetworkInterface::DEFAULT_MTU )
     : TestHarness( move( test_name ), "eth=" + to_string( ethernet_address ) + ", ip=" + ip_address.ip(), [&] {
       const Output output { std::make_shared<FramesOut>() };
-      const NetworkInterface iface { "test", output, ethernet_address, ip_address };
+      const NetworkInterface iface { "test", output, ethernet_address, ip_address, mtu };
       return InterfaceAndOutput { iface, output };
     }() )
   {}
@@ -49,9 +50,14 @@ struct SendDatagram : public Action<InterfaceAndOutput>
   SendDatagram( InternetDatagram d, Address n ) : dgram( std::move( d ) ), next_hop( n ) {}
 };
 
-inline std::string concat( const std::vector<std::string>& buffers )
+template<class Buffers>
+std::string concat( const Buffers& buffers )
 {
-  return std::accumulate( buffers.begin(), buffers.end(), std::string {} );
+  std::string ret;
+  for ( const std::string_view buffer : buffers ) {
+    ret.append( buffer );
+  }
+  return ret;
 }
 
 template<class T>
@@ -0,0 +1,193 @@
+#include "benchmark.hh"
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct Segment
+{
+  uint64_t first_index;
+  uint64_t length;
+};
+
+// Each workload delivers every byte of a `window`-byte stream at least once, in an adversarial order.
+using Workload = vector<Segment> ( * )( uint64_t window );
+
+vector<Segment> in_order( uint64_t window )
+{
+  vector<Segment> ret;
+  for ( uint64_t i = 0; i < window; i += 1000 ) {
+    ret.push_back( { i, min<uint64_t>( 1000, window - i ) } );
+  }
+  return ret;
+}
+
+vector<Segment> reverse_order( uint64_t window )
+{
+  auto ret = in_order( window );
+  reverse( ret.begin(), ret.end() );
+  return ret;
+}
+
+// Everything but one byte in every `stride`, then the one-byte holes in random order
+vector<Segment> single_byte_holes( uint64_t window )
+{
+  const uint64_t stride = max<uint64_t>( 64, window / 65536 );
+  vector<Segment> ret;
+  vector<Segment> holes;
+  for ( uint64_t i = 0; i < window; i += stride ) {
+    holes.push_back( { i, 1 } );
+    if ( i + 1 < window ) {
+      ret.push_back( { i + 1, min( stride, window - i ) - 1 } );
+    }
+  }
+  shuffle( holes.begin(), holes.end(), default_random_engine { 1370 } );
+  ret.insert( ret.end(), holes.begin(), holes.end() );
+  return ret;
+}
+
+// Every segment four times, shuffled within groups of eight segments
+vector<Segment> heavy_duplication( uint64_t window )
+{
+  const auto segments = in_order( window );
+  default_random_engine rd { 1370 };
+  vector<Segment> ret;
+  for ( size_t i = 0; i < segments.size(); i += 8 ) {
+    vector<Segment> group;
+    for ( size_t j = i; j < min( i + 8, segments.size() ); ++j ) {
+      group.insert( group.end(), 4, segments[j] );
+    }
+    shuffle( group.begin(), group.end(), rd );
+    ret.insert( ret.end(), group.begin(), group.end() );
+  }
+  return ret;
+}
+
+// Large retransmits that each overlap half of their neighbours, the odd ones first, then the even ones backwards
+vector<Segment> overlapping_retransmits( uint64_t window )
+{
+  const uint64_t size = min<uint64_t>( 65536, window / 4 );
+  vector<Segment> odd;
+  vector<Segment> even;
+  for ( uint64_t i = 0; i < window; i += size / 2 ) {
+    ( ( i / ( size / 2 ) ) % 2 ? odd : even ).push_back( { i, min( size, window - i ) } );
+  }
+  odd.insert( odd.end(), even.rbegin(), even.rend() );
+  return odd;
+}
+
+struct Result
+{
+  string workload {};
+  string placement {};
+  uint64_t window {};
+  uint64_t inserts {};
+  double seconds {};
+  uint64_t peak_pending {};
+  uint64_t peak_heap {};
+
+  double gigabits_per_second() const { return 8 * static_cast<double>( window ) / seconds / 1e9; }
+};
+
+Result run( const string& data, const string& name, Workload workload, Reassembler::Placement placement )
+{
+  const auto segments = workload( data.size() );
+  Reassembler reassembler { ByteStream { data.size() }, placement };
+
+  uint64_t peak_pending = 0;
+  const uint64_t heap_before = HeapCounter::in_use();
+  HeapCounter::reset_peak();
+  const auto start_time = steady_clock::now();
+  for ( const auto& seg : segments ) {
+    const bool last = seg.first_index + seg.length == data.size();
+    reassembler.insert( seg.first_index, data.substr( seg.first_index, seg.length ), last );
+    peak_pending = max( peak_pending, reassembler.bytes_pending() );
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t peak_heap = HeapCounter::peak() - heap_before;
+
+  string output;
+  read( reassembler.reader(), data.size(), output );
+  if ( not reassembler.reader().is_finished() or output != data ) {
+    throw runtime_error( "Mismatch between data written and read (" + name + ")" );
+  }
+
+  return { .workload = name,
+           .placement = reassembler.placement() == Reassembler::Placement::Direct ? "direct" : "buffered",
+           .window = data.size(),
+           .inserts = segments.size(),
+           .seconds = duration_cast<duration<double>>( stop_time - start_time ).count(),
+           .peak_pending = peak_pending,
+           .peak_heap = peak_heap };
+}
+
+void print( const vector<Result>& results, const Format format )
+{
+  const vector<Column> columns { { "workload", "workload", 24 },
+                                 { "placement", "placement", 10 },
+                                 { "window", "window", 10 },
+                                 { "inserts", "inserts", 10 },
+                                 { "seconds", "" },
+                                 { "gbit_per_s", "Gbit/s", 10 },
+                                 { "peak_pending", "peak pending", 14 },
+                                 { "peak_heap", "peak heap", 12 } };
+  vector<Row> rows;
+  for ( const auto& r : results ) {
+    rows.push_back( { r.workload,
+                      r.placement,
+                      r.window,
+                      r.inserts,
+                      r.seconds,
+                      r.gigabits_per_second(),
+                      r.peak_pending,
+                      r.peak_heap } );
+  }
+  ::print( columns, rows, format );
+}
+
+void program_body( const Format format )
+{
+  const vector<pair<string, Workload>> workloads { { "in_order", in_order },
+                                                   { "reverse_order", reverse_order },
+                                                   { "single_byte_holes", single_byte_holes },
+                                                   { "heavy_duplication", heavy_duplication },
+                                                   { "overlapping_retransmits", overlapping_retransmits } };
+
+  vector<Result> results;
+  for ( const uint64_t window : { 1UL << 16, 1UL << 20, 1UL << 26 } ) {
+    const string data = [&] {
+      mt19937_64 rd { window };
+      string ret( window, 0 );
+      for ( auto& c : ret ) {
+        c = static_cast<char>( rd() );
+      }
+      return ret;
+    }();
+
+    for ( const auto& [name, workload] : workloads ) {
+      for ( const auto placement : { Reassembler::Placement::Buffered, Reassembler::Placement::Direct } ) {
+        results.push_back( run( data, name, workload, placement ) );
+      }
+    }
+  }
+
+  print( results, format );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return benchmark_main( argc, argv, program_body );
+}
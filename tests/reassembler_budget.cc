@@ -0,0 +1,88 @@
+#include "reassembler_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    const auto buffered = Reassembler::Placement::Buffered;
+
+    {
+      // the furthest segment of the whole group goes first
+      auto budget = make_shared<ReassemblyBudget>( 10 );
+      ReassemblerTestHarness near { "budget: the closer member", 100, buffered, budget };
+      ReassemblerTestHarness far { "budget: the further member", 100, buffered, budget };
+
+      near.execute( Insert { "cd", 2 } );
+      far.execute( Insert { "xyzw", 50 } );
+      near.execute( Insert { "kl", 10 } );
+      test_should_be( budget->in_use(), uint64_t { 8 } );
+
+      // 4 more bytes don't fit: far's segment (ending 54 bytes out) is evicted, not near's
+      near.execute( Insert { "uvwx", 20 } );
+      test_should_be( budget->in_use(), uint64_t { 8 } );
+      far.execute( BytesPending { 0 } );
+      far.execute( Evictions { 1 } );
+      near.execute( BytesPending { 8 } );
+      near.execute( Evictions { 0 } );
+
+      // a new segment further out than everything pending is dropped instead
+      far.execute( Insert { "!!!!", 90 } );
+      far.execute( BytesPending { 0 } );
+      far.execute( Evictions { 2 } );
+      test_should_be( budget->evictions(), uint64_t { 2 } );
+
+      // near evicts its own furthest segment ("uvwx") to make room for a closer one
+      near.execute( Insert { "fgh", 5 } );
+      near.execute( BytesPending { 7 } );
+      near.execute( Evictions { 1 } );
+
+      near.execute( Insert { "ab", 0 } );
+      near.execute( Insert { "e", 4 } );
+      near.execute( Insert { "ij", 8 } );
+      near.execute( ReadAll { "abcdefghijkl" } );
+      test_should_be( budget->in_use(), uint64_t { 0 } );
+    }
+
+    {
+      // in-order data is never charged, and copies charge what they hold
+      auto budget = make_shared<ReassemblyBudget>( 4 );
+      Reassembler r { ByteStream { 100 }, buffered, budget };
+      r.insert( 0, string( 50, 'x' ), false );
+      r.insert( 60, "abc", false );
+      test_should_be( budget->in_use(), uint64_t { 3 } );
+      {
+        const Reassembler copy { r };
+        test_should_be( budget->in_use(), uint64_t { 6 } );
+      }
+      test_should_be( budget->in_use(), uint64_t { 3 } );
+
+      // the moved Reassembler is still a member
+      Reassembler moved { std::move( r ) };
+      moved.insert( 55, "de", false );
+      test_should_be( moved.evictions(), uint64_t { 1 } );
+      test_should_be( moved.bytes_pending(), uint64_t { 2 } );
+    }
+
+    {
+      // Direct placement keeps out-of-order bytes in the stream and doesn't charge the budget
+      auto budget = make_shared<ReassemblyBudget>( 1 );
+      ReassemblerTestHarness test { "budget: direct placement", 100, Reassembler::Placement::Direct, budget };
+      test.execute( Insert { "abcdef", 10 } );
+      test.execute( BytesPending { 6 } );
+      test_should_be( budget->in_use(), uint64_t { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto placement : { Reassembler::Placement::Buffered, Reassembler::Placement::Direct } ) {
+      ReassemblerTestHarness test { "counters", 10, ByteStream::Storage::Ring, placement };
+
+      test.execute( Insert { "cd", 2 } );  // opens a gap at index 0
+      test.execute( Insert { "bcd", 1 } ); // "cd" is already pending
+      test.execute( Insert { "zz", 20 } ); // past the window
+      test.execute( ExpectCounters {}.with_duplicate_bytes( 2 ).with_beyond_capacity_bytes( 2 ) );
+      test.execute( ExpectCounters {}.with_merges( 0 ).with_holes_filled( 0 ) );
+
+      test.execute( Insert { "a", 0 } ); // fills the gap on the fourth insert
+      test.execute( ReadAll { "abcd" } );
+      test.execute( ExpectCounters {}.with_merges( 1 ).with_holes_filled( 1 ).with_fill_inserts( 3, 3 ) );
+
+      test.execute( Insert { "abcd", 0 } ); // already written
+      test.execute( ExpectCounters {}.with_duplicate_bytes( 6 ) );
+
+      test.execute( Insert { "gh", 6 } ); // opens a gap at index 4
+      test.execute( Insert { "ij", 8 }.is_last() );
+      test.execute( ExpectCounters {}.with_peak_bytes_pending( 4 ) );
+      test.execute( Insert { "ef", 4 } );
+      test.execute( ReadAll { "efghij" } );
+      test.execute( IsFinished { true } );
+
+      // peak segments are counted only when buffered
+      test.execute( ExpectCounters {}
+                      .with_inserts( 8 )
+                      .with_merges( 2 )
+                      .with_holes_filled( 2 )
+                      .with_fill_inserts( 5, 3 )
+                      .with_peak_pending_segments( placement == Reassembler::Placement::Buffered ? 2 : 0 )
+                      .with_evictions( 0 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
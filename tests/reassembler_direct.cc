@@ -0,0 +1,109 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring,
+                                 ByteStream::Storage::Mirrored,
+                                 ByteStream::Storage::Chunked,
+                                 ByteStream::Storage::Pooled } ) {
+      const auto direct = Reassembler::Placement::Direct;
+      const bool supported = storage == ByteStream::Storage::Ring or storage == ByteStream::Storage::Mirrored;
+
+      {
+        ReassemblerTestHarness test { "direct placement granted", 8, storage, direct };
+        if ( ( test.placement() == direct ) != supported ) {
+          throw runtime_error( "Direct placement should be granted exactly for Ring and Mirrored storage" );
+        }
+      }
+
+      {
+        ReassemblerTestHarness test { "direct holes", 16, storage, direct };
+
+        test.execute( Insert { "ef", 4 } );
+        test.execute( Insert { "b", 1 } );
+        test.execute( BytesPending { 3 } );
+        test.execute( BytesPushed { 0 } );
+
+        // filling the first hole publishes everything up to the next one
+        test.execute( Insert { "a", 0 } );
+        test.execute( BytesPushed { 2 } );
+        test.execute( BytesPending { 2 } );
+
+        test.execute( Insert { "cd", 2 } );
+        test.execute( BytesPushed { 6 } );
+        test.execute( BytesPending { 0 } );
+        test.execute( ReadAll { "abcdef" } );
+      }
+
+      {
+        ReassemblerTestHarness test { "direct overlap and duplicates", 16, storage, direct };
+
+        test.execute( Insert { "cdef", 2 } );
+        test.execute( Insert { "defgh", 3 } );
+        test.execute( Insert { "cd", 2 } );
+        test.execute( BytesPending { 6 } );
+        test.execute( Insert { "abc", 0 } );
+        test.execute( BytesPending { 0 } );
+        test.execute( Insert { "ghij", 6 }.is_last() );
+        test.execute( BytesPushed { 10 } );
+        test.execute( ReadAll { "abcdefghij" } );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        ReassemblerTestHarness test { "direct capacity", 4, storage, direct };
+
+        // bytes beyond the window are dropped
+        test.execute( Insert { "cdefgh", 2 } );
+        test.execute( BytesPending { 2 } );
+        test.execute( Insert { "ab", 0 } );
+        test.execute( BytesPushed { 4 } );
+        test.execute( ReadAll { "abcd" } );
+
+        // the window has moved on, and wraps around the ring and the bitset
+        test.execute( Insert { "gh", 6 } );
+        test.execute( Insert { "efgh", 4 } );
+        test.execute( BytesPushed { 8 } );
+        test.execute( Insert { "ijk", 8 } );
+        test.execute( BytesPushed { 8 } );
+        test.execute( Pop { 2 } );
+        test.execute( Insert { "ijk", 8 }.is_last() );
+        test.execute( BytesPushed { 10 } );
+        test.execute( IsFinished { false } );
+        test.execute( ReadAll { "ghij" } );
+        test.execute( Insert { "k", 10 } );
+        test.execute( ReadAll { "k" } );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        // many holes of one byte, filled from the back
+        ReassemblerTestHarness test { "direct many holes", 200, storage, direct };
+        string expected;
+        for ( size_t i = 0; i < 200; ++i ) {
+          expected += static_cast<char>( 'a' + i % 26 );
+        }
+        for ( size_t i = 1; i < 200; i += 2 ) {
+          test.execute( Insert { expected.substr( i, 1 ), i } );
+        }
+        test.execute( BytesPending { 100 } );
+        for ( size_t i = 200; i > 0; i -= 2 ) {
+          test.execute( Insert { expected.substr( i - 2, 1 ), i - 2 } );
+        }
+        test.execute( BytesPending { 0 } );
+        test.execute( ReadAll { expected } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto placement : { Reassembler::Placement::Buffered, Reassembler::Placement::Direct } ) {
+      ReassemblerTestHarness test { "SACK intervals", 100, ByteStream::Storage::Ring, placement };
+      test.execute( PendingIntervals { 4, {} } );
+
+      test.execute( Insert { "klm", 10 } );
+      test.execute( Insert { "uv", 20 } );
+      test.execute( Insert { "no", 13 } ); // touches "klm"
+      test.execute( PendingIntervals { 4, { { 10, 15 }, { 20, 22 } } } ); // most recent first, coalesced
+
+      test.execute( Insert { "EF", 30 } );
+      test.execute( Insert { "OP", 40 } );
+      test.execute( Insert { "YZ", 50 } );
+      test.execute( Insert { "ij", 60 } );
+      test.execute( PendingIntervals { 3, { { 60, 62 }, { 50, 52 }, { 40, 42 } } } );
+
+      // the four most recent inserts are remembered; the rest come from the lowest up
+      test.execute(
+        PendingIntervals { 6, { { 60, 62 }, { 50, 52 }, { 40, 42 }, { 30, 32 }, { 10, 15 }, { 20, 22 } } } );
+
+      test.execute( Insert { "abcdefghijklmnopqrstu", 0 } ); // fills up to 22
+      test.execute( BytesPushed { 22 } );
+      test.execute( PendingIntervals { 6, { { 60, 62 }, { 50, 52 }, { 40, 42 }, { 30, 32 } } } );
+
+      test.execute( Insert { "xyz", 98 } ); // cut at the capacity
+      test.execute( PendingIntervals { 1, { { 98, 100 } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
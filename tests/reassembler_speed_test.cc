@@ -13,9 +13,15 @@
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+string placement_name( const Reassembler::Placement placement )
+{
+  return placement == Reassembler::Placement::Direct ? "direct" : "buffered";
+}
+
+void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const Reassembler::Placement placement = Reassembler::Placement::Buffered )
 {
   // Generate the data to be written
   const string data = [&] {
@@ -36,7 +42,7 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
     split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
   }
 
-  Reassembler reassembler { ByteStream { capacity } };
+  Reassembler reassembler { ByteStream { capacity }, placement };
 
   string output_data;
   output_data.reserve( data.size() );
@@ -71,20 +77,68 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  cout << "Reassembler (" << placement_name( reassembler.placement() ) << ") to ByteStream with capacity=" << capacity
+       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
-               << " Gbit/s\n";
+  debug_output << "             Reassembler throughput (" << placement_name( reassembler.placement() )
+               << "): " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
     throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
   }
 }
 
+// Leave a hole before every segment, then fill the holes from the back: each fill touches two of
+// the many pending segments, so an insert that scans every pending segment makes this quadratic.
+void holes_speed_test( const size_t num_segments, // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                       const Reassembler::Placement placement = Reassembler::Placement::Buffered )
+{
+  const string data = [&] {
+    default_random_engine rd { num_segments };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < 2 * num_segments * segment_size; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  Reassembler reassembler { ByteStream { data.size() }, placement };
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 1; i < 2 * num_segments; i += 2 ) {
+    reassembler.insert( i * segment_size, data.substr( i * segment_size, segment_size ), i + 1 == 2 * num_segments );
+  }
+  for ( size_t i = 2 * num_segments; i > 0; i -= 2 ) {
+    reassembler.insert( ( i - 2 ) * segment_size, data.substr( ( i - 2 ) * segment_size, segment_size ), false );
+  }
+  const auto stop_time = steady_clock::now();
+
+  string output_data;
+  read( reassembler.reader(), data.size(), output_data );
+  if ( not reassembler.reader().is_finished() or data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto gigabits_per_second = 8 * static_cast<double>( data.size() ) / test_duration.count() / 1e9;
+
+  cout << "Reassembler (" << placement_name( reassembler.placement() ) << ") filling " << num_segments
+       << " holes of " << segment_size << " bytes reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s.\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s with many holes." );
+  }
+}
+
 void program_body()
 {
   speed_test( 10000, 1500, 1370 );
+  speed_test( 10000, 1500, 1370, Reassembler::Placement::Direct );
+  holes_speed_test( 50000, 100 );
+  holes_speed_test( 50000, 100, Reassembler::Placement::Direct );
 }
 
 int main()
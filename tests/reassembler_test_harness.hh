@@ -4,9 +4,12 @@
 #include "common.hh"
 #include "reassembler.hh"
 
+#include <memory>
 #include <optional>
 #include <sstream>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<ByteStream>> T>
 struct ReassemblerTestStep : public TestStep<Reassembler>
@@ -33,6 +36,29 @@ public:
                    { Reassembler { ByteStream { capacity } } } )
   {}
 
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          ByteStream::Storage storage,
+                          Reassembler::Placement placement )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", storage=" + storage_name( storage )
+                     + ( placement == Reassembler::Placement::Direct ? ", direct placement" : "" ),
+                   { Reassembler { ByteStream { capacity, storage }, placement } } )
+  {}
+
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Placement placement,
+                          std::shared_ptr<ReassemblyBudget> budget )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( placement == Reassembler::Placement::Direct ? ", direct placement" : "" )
+                     + ( budget ? ", shared budget" : "" ),
+                   { Reassembler { ByteStream { capacity }, placement, std::move( budget ) } } )
+  {}
+
+  Reassembler::Placement placement() const { return object().placement(); }
+
   template<std::derived_from<TestStep<ByteStream>> T>
   void execute( const T& test )
   {
@@ -49,6 +75,110 @@ struct BytesPending : public ConstExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.bytes_pending(); }
 };
 
+struct Evictions : public ConstExpectNumber<Reassembler, uint64_t>
+{
+  using ConstExpectNumber::ConstExpectNumber;
+  std::string name() const override { return "evictions"; }
+  uint64_t value( const Reassembler& r ) const override { return r.evictions(); }
+};
+
+// The counters given by the with_*() calls have those values (the others aren't checked)
+struct ExpectCounters : public Expectation<Reassembler>
+{
+  using Counter = uint64_t Reassembler::Counters::*;
+  std::vector<std::tuple<std::string, Counter, uint64_t>> expected_ {};
+
+  ExpectCounters& with( std::string name, Counter counter, uint64_t value )
+  {
+    expected_.emplace_back( std::move( name ), counter, value );
+    return *this;
+  }
+
+  ExpectCounters& with_inserts( uint64_t n ) { return with( "inserts", &Reassembler::Counters::inserts, n ); }
+  ExpectCounters& with_duplicate_bytes( uint64_t n )
+  {
+    return with( "duplicate_bytes", &Reassembler::Counters::duplicate_bytes, n );
+  }
+  ExpectCounters& with_beyond_capacity_bytes( uint64_t n )
+  {
+    return with( "beyond_capacity_bytes", &Reassembler::Counters::beyond_capacity_bytes, n );
+  }
+  ExpectCounters& with_evictions( uint64_t n ) { return with( "evictions", &Reassembler::Counters::evictions, n ); }
+  ExpectCounters& with_merges( uint64_t n ) { return with( "merges", &Reassembler::Counters::merges, n ); }
+  ExpectCounters& with_peak_pending_segments( uint64_t n )
+  {
+    return with( "peak_pending_segments", &Reassembler::Counters::peak_pending_segments, n );
+  }
+  ExpectCounters& with_peak_bytes_pending( uint64_t n )
+  {
+    return with( "peak_bytes_pending", &Reassembler::Counters::peak_bytes_pending, n );
+  }
+  ExpectCounters& with_holes_filled( uint64_t n )
+  {
+    return with( "holes_filled", &Reassembler::Counters::holes_filled, n );
+  }
+  ExpectCounters& with_fill_inserts( uint64_t total, uint64_t max )
+  {
+    with( "fill_inserts_total", &Reassembler::Counters::fill_inserts_total, total );
+    return with( "fill_inserts_max", &Reassembler::Counters::fill_inserts_max, max );
+  }
+
+  std::string description() const override
+  {
+    std::string ret = "counters";
+    for ( size_t i = 0; i < expected_.size(); ++i ) {
+      const auto& [name, counter, value] = expected_[i];
+      ret += ( i == 0 ? " " : ", " ) + name + " = " + std::to_string( value );
+    }
+    return ret;
+  }
+
+  void execute( Reassembler& r ) const override
+  {
+    for ( const auto& [name, counter, value] : expected_ ) {
+      if ( r.counters().*counter != value ) {
+        throw ExpectationViolation { "counters." + name, value, r.counters().*counter };
+      }
+    }
+  }
+};
+
+// What the Reassembler would report in SACK blocks: at most `max_intervals` [first, last) intervals
+struct PendingIntervals : public Expectation<Reassembler>
+{
+  size_t max_intervals_;
+  std::vector<std::pair<uint64_t, uint64_t>> intervals_;
+
+  PendingIntervals( size_t max_intervals, std::vector<std::pair<uint64_t, uint64_t>> intervals )
+    : max_intervals_( max_intervals ), intervals_( std::move( intervals ) )
+  {}
+
+  static std::string str( const std::vector<std::pair<uint64_t, uint64_t>>& intervals )
+  {
+    std::ostringstream ss;
+    ss << "{";
+    for ( const auto& [first, last] : intervals ) {
+      ss << " [" << first << ", " << last << ")";
+    }
+    ss << " }";
+    return ss.str();
+  }
+
+  std::string description() const override
+  {
+    return "pending_intervals( " + std::to_string( max_intervals_ ) + " ) = " + str( intervals_ );
+  }
+
+  void execute( Reassembler& r ) const override
+  {
+    const auto got = r.pending_intervals( max_intervals_ );
+    if ( got != intervals_ ) {
+      throw ExpectationViolation { "Expected pending intervals " + str( intervals_ ) + ", but found "
+                                   + str( got ) };
+    }
+  }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
@@ -68,6 +68,15 @@ struct ExpectWindow : public ExpectNumber<TCPReceiver, uint16_t>
   uint16_t value( TCPReceiver& rs ) const override { return rs.send().window_size; }
 };
 
+struct SetWindowShift : public Action<TCPReceiver>
+{
+  uint8_t shift_;
+
+  explicit SetWindowShift( uint8_t shift ) : shift_( shift ) {}
+  std::string description() const override { return "set_window_shift(" + std::to_string( shift_ ) + ")"; }
+  void execute( TCPReceiver& rs ) const override { rs.set_window_shift( shift_ ); }
+};
+
 struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
 {
   using ExpectNumber::ExpectNumber;
@@ -75,6 +84,13 @@ struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
   std::optional<Wrap32> value( TCPReceiver& rs ) const override { return rs.send().ackno; }
 };
 
+struct ExpectSACK : public ExpectNumber<TCPReceiver, std::vector<SACKBlock>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sack"; }
+  std::vector<SACKBlock> value( TCPReceiver& rs ) const override { return rs.send().sack; }
+};
+
 struct ExpectReset : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -141,6 +157,12 @@ struct SegmentArrives : public Action<TCPReceiver>
     return *this;
   }
 
+  SegmentArrives& with_sack_permitted()
+  {
+    msg_.SACK_permitted = true;
+    return *this;
+  }
+
   SegmentArrives& with_seqno( Wrap32 seqno_ )
   {
     msg_.seqno = seqno_;
@@ -175,6 +197,9 @@ struct SegmentArrives : public Action<TCPReceiver>
     if ( msg_.SYN ) {
       ss << " +SYN";
     }
+    if ( msg_.SACK_permitted ) {
+      ss << " +SACK_permitted";
+    }
     if ( not msg_.payload.empty() ) {
       ss << " payload=\"" << Printer::prettify( msg_.payload ) << "\"";
     }
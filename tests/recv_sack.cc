@@ -0,0 +1,62 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      const auto block = [&]( uint32_t left, uint32_t right ) {
+        return SACKBlock { Wrap32 { isn + left }, Wrap32 { isn + right } };
+      };
+      TCPReceiverTestHarness test { "SACK blocks, most recent first", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+      test.execute( ExpectSACK { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACK { { block( 5, 9 ) } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mn" ) );
+      test.execute( ExpectSACK { { block( 13, 15 ), block( 5, 9 ) } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectSACK { { block( 5, 15 ) } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 20 ).with_data( "tu" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 30 ).with_data( "DE" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 40 ).with_data( "NO" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 50 ).with_data( "XY" ) );
+      test.execute( ExpectSACK { { block( 50, 52 ), block( 40, 42 ), block( 30, 32 ), block( 20, 22 ) } } );
+
+      // a duplicate makes its block the most recent again
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ij" ) );
+      test.execute( ExpectSACK { { block( 5, 15 ), block( 50, 52 ), block( 40, 42 ), block( 30, 32 ) } } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 15 } } );
+      test.execute( ExpectSACK { { block( 50, 52 ), block( 40, 42 ), block( 20, 22 ), block( 30, 32 ) } } );
+      test.execute( ReadAll { "abcdefghijklmn" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks unless the SYN permitted them", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( BytesPending { 4 } );
+      test.execute( ExpectSACK { {} } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
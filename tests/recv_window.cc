@@ -29,6 +29,20 @@ int main()
       test.execute( ExpectWindow { cap - 12 } );
     }
 
+    {
+      const size_t cap = 32 << 20;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "scaled window", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( SetWindowShift { 10 } );
+      test.execute( ExpectWindow { cap >> 10 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 1000, 'x' ) ) );
+      test.execute( ExpectWindow { ( cap - 1000 ) >> 10 } ); // rounded down: never more than fits
+      test.execute( SegmentArrives {}.with_seqno( isn + 1001 ).with_data( string( 24, 'x' ) ) );
+      test.execute( ExpectWindow { ( cap >> 10 ) - 1 } );
+    }
+
     {
       const size_t cap = 4000;
       const uint32_t isn = 23452;
@@ -0,0 +1,127 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr auto NONE = CongestionControl::Algorithm::None;
+constexpr auto NAGLE = Coalescing::Nagle;
+constexpr auto AUTOCORK = Coalescing::Autocork;
+
+// Send SYN, get it acked, then send "a" with nothing else in flight
+void send_first_byte( TCPSenderTestHarness& test, const Wrap32 isn )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( AckReceived { isn + 1 }.with_win( 10000 ) );
+  test.execute( Push { "a" } );
+  test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Nagle: short segments wait for the ack", cfg, NONE, {}, NAGLE };
+      send_first_byte( test, isn );
+      test.execute( Push { "b" } );
+      test.execute( Push { "c" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 2 }.with_win( 10000 ) );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_data( "bc" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Nagle: full segments go at once", cfg, NONE, {}, NAGLE };
+      send_first_byte( test, isn );
+      test.execute( Push { string( 2500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1002 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 2002 }.with_win( 10000 ) );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 2002 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Nagle: the end of the stream doesn't wait", cfg, NONE, {}, NAGLE };
+      send_first_byte( test, isn );
+      test.execute( Push { "b" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push { "c" }.with_close() );
+      test.execute( ExpectMessage {}.with_data( "bc" ).with_fin( true ).with_seqno( isn + 2 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Autocork: short segments wait for the clock", cfg, NONE, {}, AUTOCORK };
+      send_first_byte( test, isn );
+      test.execute( Push { "b" } );
+      test.execute( Push { "c" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( TickMicroseconds { 1 } );
+      test.execute( ExpectMessage {}.with_data( "bc" ).with_seqno( isn + 2 ) ); // no push needed
+      test.execute( Push { "d" } );
+      test.execute( Push { "e" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( TickMicroseconds { 1 } );
+      test.execute( ExpectMessage {}.with_data( "de" ).with_seqno( isn + 4 ) );
+      test.execute( Push { "f" } );
+      test.execute( ExpectNoSegment {} );
+
+      // without anything in flight, nothing waits
+      test.execute( AckReceived { isn + 6 }.with_win( 10000 ) );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_data( "f" ).with_seqno( isn + 6 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Retransmissions don't wait", cfg, NONE, {}, NAGLE };
+      send_first_byte( test, isn );
+      test.execute( Push { "b" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
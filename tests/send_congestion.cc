@@ -0,0 +1,153 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr auto NEWRENO = CongestionControl::Algorithm::NewReno;
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "NewReno: the first flight is the initial window", cfg, NEWRENO };
+      test.connect( 60000 );
+      test.execute( ExpectCwnd { 10 * TCPConfig::MAX_PAYLOAD_SIZE + 1 } ); // the SYN's ack grew it by one
+      test.execute( Push { string( 20000, 'x' ) } );
+      for ( unsigned i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + i * 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 1 ).with_seqno( isn + 10001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 10001 } );
+
+      // slow start: one ack for all of it grows the window by at most two segments
+      test.execute( AckReceived { isn + 10002 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 12001 } );
+      for ( unsigned i = 0; i < 9; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 999 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 9999 } );
+
+      // a timeout collapses the window to one segment
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 10002 ) );
+      test.execute( ExpectCwnd { 1000 } );
+
+      // ... and slow start begins again
+      test.execute( AckReceived { isn + 20001 }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectCwnd { 3000 } );
+      test.execute( Push { string( 5000, 'x' ) } );
+      for ( unsigned i = 0; i < 3; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "NewReno: a loss found by SACK halves the window, once", cfg, NEWRENO };
+      test.connect( 60000 );
+      for ( const string byte : { "a", "b", "c", "d", "e", "f" } ) {
+        test.execute( Push { byte } );
+        test.execute( ExpectMessage {}.with_data( byte ) );
+      }
+
+      // "a" and "b" are lost: the window falls once, to two segments (half of the pipe, at least)
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ).with_sack( isn + 3, isn + 7 ) );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 2000 } );
+      test.execute( ExpectInRecovery { true } );
+
+      // recovery ends once everything sent before the loss is acked
+      test.execute( AckReceived { isn + 3 }.with_win( 60000 ).with_sack( isn + 3, isn + 7 ) );
+      test.execute( ExpectInRecovery { true } );
+      test.execute( AckReceived { isn + 7 }.with_win( 60000 ) );
+      test.execute( ExpectInRecovery { false } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+
+      // congestion avoidance from here
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "The receiver's window still limits the sender", cfg, NEWRENO };
+      test.connect( 1500 );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "NewReno: holes are resent only as far as the window allows", cfg, NEWRENO };
+      test.connect( 60000 );
+      test.execute( Push { string( 10000, 'x' ) } );
+      for ( unsigned i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + i * 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // the first, third and fifth segments are lost: the window falls to two segments, and the pipe to none
+      test.execute( AckReceived { isn + 1 }
+                      .with_win( 60000 )
+                      .with_sack( isn + 1001, isn + 2001 )
+                      .with_sack( isn + 3001, isn + 4001 )
+                      .with_sack( isn + 5001, isn + 10001 ) );
+      test.execute( ExpectCwnd { 2000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the third hole waits until a resent segment leaves the pipe
+      test.execute( AckReceived { isn + 1001 }
+                      .with_win( 60000 )
+                      .with_sack( isn + 1001, isn + 2001 )
+                      .with_sack( isn + 3001, isn + 4001 )
+                      .with_sack( isn + 5001, isn + 10001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 4001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
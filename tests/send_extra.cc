@@ -472,6 +472,9 @@ int main()
       test.execute( AckReceived { Wrap32 { isn + 8 } }.with_win( 1000 ) );
       test.execute( AckReceived { Wrap32 { isn + 8 } }.with_win( 1000 ) );
       test.execute( AckReceived { Wrap32 { isn + 8 } }.with_win( 1000 ) );
+      // the third duplicate ack (with "ijkl" outstanding) triggers a fast retransmit
+      test.execute(
+        ExpectMessage {}.with_payload_size( 4 ).with_data( "ijkl" ).with_seqno( isn + 8 ).with_fin( true ) );
       test.execute( AckReceived { Wrap32 { isn + 12 } }.with_win( 1000 ) );
       test.execute( AckReceived { Wrap32 { isn + 12 } }.with_win( 1000 ) );
       test.execute( AckReceived { Wrap32 { isn + 12 } }.with_win( 1000 ) );
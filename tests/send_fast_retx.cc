@@ -0,0 +1,123 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "The third duplicate ack retransmits, once", cfg };
+      test.send_bytes( "abcde" );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ) );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ) );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ) );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the next loss needs three new duplicates
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ) );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ) );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "d" ).with_seqno( isn + 4 ) );
+      test.execute( AckReceived { isn + 6 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Window updates aren't duplicate acks", cfg };
+      test.send_bytes( "abc" );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 999 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 998 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 997 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Nothing outstanding, nothing to retransmit", cfg };
+      test.send_bytes( "ab" );
+      test.execute( AckReceived { isn + 3 }.with_win( 1000 ) );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( AckReceived { isn + 3 }.with_win( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push { "c" } );
+      test.execute( ExpectMessage {}.with_data( "c" ) );
+      test.execute( AckReceived { isn + 3 }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Limited transmit: a new segment for each of the first two duplicates",
+                                  cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+
+      // the initial window (grown by one for the SYN's ack) is full
+      test.execute( Push { string( 12000, 'x' ) } );
+      for ( unsigned i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + i * 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 10002 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 999 ).with_seqno( isn + 11002 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the third retransmits and halves the window: nothing new until the loss is repaired
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 6000 } );
+      test.execute( ExpectInRecovery { true } );
+
+      test.execute( AckReceived { isn + 12001 }.with_win( 60000 ) );
+      test.execute( ExpectInRecovery { false } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr auto NONE = CongestionControl::Algorithm::None;
+constexpr auto NEWRENO = CongestionControl::Algorithm::NewReno;
+constexpr uint16_t WINDOW = 60000;
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "A delivered probe raises the MSS", cfg, NONE };
+      test.connect( WINDOW );
+      test.execute( SetMSS { 1000, 8960 } ); // a jumbo-frame peer
+
+      // the first segment probes the largest size; the rest stay at the MSS until it's acked
+      test.execute( Push { string( 20000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 8960 ).with_seqno( isn + 1 ) );
+      for ( uint32_t i = 0; i < 11; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 8961 + i * 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 40 ).with_seqno( isn + 19961 ) );
+      test.execute( ExpectProbing { true } );
+      test.execute( ExpectMSS { 1000 } );
+
+      test.execute( AckReceived { isn + 8961 }.with_win( WINDOW ) );
+      test.execute( ExpectProbing { false } );
+      test.execute( ExpectMSS { 8960 } );
+
+      // the search is over
+      test.execute( Push { string( 20000, 'y' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 8960 ).with_seqno( isn + 20001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 8960 ).with_seqno( isn + 28961 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 2080 ).with_seqno( isn + 37921 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectProbing { false } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "A probe lost to a timeout is resent in pieces", cfg, NONE };
+      test.connect( WINDOW );
+      test.execute( SetMSS { 1000, 1460 } );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 540 ).with_seqno( isn + 4461 ) );
+
+      // no backing off: the path may just not carry segments that large
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      test.execute( ExpectRTO { cfg.rt_timeout * 1000ULL } );
+      test.execute( ExpectProbing { false } );
+      test.execute( ExpectMSS { 1000 } );
+
+      test.execute( AckReceived { isn + 1001 }.with_win( WINDOW ) );
+      test.execute( ExpectMessage {}.with_payload_size( 460 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the next probe is halfway between
+      test.execute( Push { string( 3000, 'y' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1230 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6231 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 770 ).with_seqno( isn + 7231 ) );
+      test.execute( AckReceived { isn + 8001 }.with_win( WINDOW ) );
+      test.execute( ExpectMSS { 1230 } );
+
+      test.execute( Push { string( 2000, 'z' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1345 ).with_seqno( isn + 8001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 655 ).with_seqno( isn + 9346 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "A probe lost to SACKs isn't congestion", cfg, NEWRENO };
+      test.connect( WINDOW );
+      test.execute( SetMSS { 1000, 1460 } );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 540 ).with_seqno( isn + 4461 ) );
+
+      test.execute( AckReceived { isn + 1 }.with_win( WINDOW ).with_sack( isn + 1461, isn + 4461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 460 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectInRecovery { false } );
+      test.execute( ExpectMSS { 1000 } );
+
+      // a SACKed probe counts as delivered
+      test.execute( Push { string( 3000, 'y' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1230 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6231 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 770 ).with_seqno( isn + 7231 ) );
+      test.execute( AckReceived { isn + 5001 }.with_win( WINDOW ).with_sack( isn + 5001, isn + 6231 ) );
+      test.execute( ExpectMSS { 1230 } );
+      test.execute( ExpectProbing { false } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
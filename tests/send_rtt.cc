@@ -0,0 +1,136 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr auto NONE = CongestionControl::Algorithm::None;
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test {
+        "RTO follows the RTT estimate", cfg, NONE, TCPSender::RTOBounds { 1'000, 60'000'000 } };
+      test.execute( ExpectRTO { 1'000'000 } );
+      test.connect( 1000, 100'000 );
+      test.execute( ExpectSRTT { 100'000 } );
+      test.execute( ExpectRTO { 300'000 } ); // SRTT + 4 * RTTVAR, with RTTVAR = RTT / 2
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 299 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 600'000 } );
+
+      // Karn's rule: no sample from the ack of a retransmitted segment
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ) );
+      test.execute( ExpectSRTT { 100'000 } );
+      test.execute( ExpectRTO { 300'000 } );
+
+      test.execute( Push { "d" } );
+      test.execute( ExpectMessage {}.with_data( "d" ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { isn + 5 }.with_win( 1000 ) );
+      test.execute( ExpectSRTT { 90'000 } ); // 7/8 * 100 ms + 1/8 * 20 ms
+      test.execute( ExpectRTO { 320'000 } ); // RTTVAR = 3/4 * 50 ms + 1/4 * 80 ms
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test {
+        "RTO is clamped to the minimum", cfg, NONE, TCPSender::RTOBounds { 200'000, 60'000'000 } };
+      test.connect( 1000, 2'000 );
+      test.execute( ExpectSRTT { 2'000 } );
+      test.execute( ExpectRTO { 200'000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "RTO is clamped to the maximum", cfg, NONE, TCPSender::RTOBounds { 1'000, 500'000 } };
+      test.connect( 1000, 400'000 );
+      test.execute( ExpectSRTT { 400'000 } );
+      test.execute( ExpectRTO { 500'000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Sub-millisecond RTTs", cfg, NONE, TCPSender::RTOBounds { 0, 60'000'000 } };
+      test.connect( 1000, 500 );
+      test.execute( ExpectSRTT { 500 } );
+      test.execute( ExpectRTO { 1'500 } ); // SRTT + 4 * RTTVAR, with RTTVAR = RTT / 2
+
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( TickMicroseconds { 1'499 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( TickMicroseconds { 1 } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+    }
+
+    for ( const uint64_t granularity_us : { 1'000UL, 100UL } ) {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "A steady RTT leaves the RTO at SRTT + G (G=" + to_string( granularity_us ) + " us)",
+                                  cfg,
+                                  NONE,
+                                  TCPSender::RTOBounds { 0, 60'000'000, granularity_us } };
+      test.connect( 1000, 500 );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( Push { "x" } );
+        test.execute( ExpectMessage {}.with_data( "x" ) );
+        test.execute( TickMicroseconds { 500 } );
+        test.execute( AckReceived { isn + 2 + i }.with_win( 1000 ) );
+      }
+      test.execute( ExpectSRTT { 500 } );
+      test.execute( ExpectRTO { 500 + granularity_us } ); // RTTVAR has decayed below G / 4
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 200, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Without RTO bounds, the RTO stays put", cfg };
+      test.connect( 1000, 100'000 );
+      test.execute( ExpectSRTT { 100'000 } );
+      test.execute( ExpectRTO { retx_timeout * 1000UL } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
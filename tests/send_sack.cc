@@ -0,0 +1,131 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Holes found by SACK are retransmitted, once", cfg };
+      test.send_bytes( "abcdef" );
+
+      // two SACKed segments after "a" aren't enough to presume it lost
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 3, isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // three are: "a" and "b" are holes
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 3, isn + 6 ) );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // further SACKs don't resend them
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 3, isn + 7 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 6 } );
+
+      test.execute( AckReceived { isn + 7 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Timeouts skip what the receiver holds", cfg };
+      test.send_bytes( "abcdefg" );
+
+      // "a" and "c" are lost; "b", "d", "e" and "f" arrived
+      test.execute(
+        AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 3 ).with_sack( isn + 4, isn + 7 ) );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "c" ).with_seqno( isn + 3 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // "a" arrives, "c" is lost again: the timeout resends "c", not "b"
+      test.execute( AckReceived { isn + 3 }.with_win( 1000 ).with_sack( isn + 4, isn + 7 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_data( "c" ).with_seqno( isn + 3 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 7 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 1 } );
+      test.execute( AckReceived { isn + 8 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "The loss threshold follows the newest SACKs", cfg };
+      test.send_bytes( "abcdefghij" );
+
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 4, isn + 7 ) );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectMessage {}.with_data( "c" ).with_seqno( isn + 3 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // "g" is now three SACKed segments from the end; a late SACK for "b" changes nothing
+      test.execute(
+        AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 4, isn + 7 ).with_sack( isn + 8, isn + 11 ) );
+      test.execute( ExpectMessage {}.with_data( "g" ).with_seqno( isn + 7 ) );
+      test.execute(
+        AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 3 ).with_sack( isn + 4, isn + 11 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // once everything is acked, the count starts over
+      test.execute( AckReceived { isn + 11 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      for ( const string byte : { "k", "l", "m", "n" } ) {
+        test.execute( Push { byte } );
+      }
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1 ).with_seqno( isn + 11 + i ) );
+      }
+      test.execute( AckReceived { isn + 11 }.with_win( 1000 ).with_sack( isn + 12, isn + 14 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 11 }.with_win( 1000 ).with_sack( isn + 12, isn + 15 ) );
+      test.execute( ExpectMessage {}.with_data( "k" ).with_seqno( isn + 11 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "SACK blocks outside the outstanding data are ignored", cfg };
+      test.send_bytes( "abcd" );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 9 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + ( UINT32_MAX - 4 ), isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -31,6 +31,32 @@ int main()
       test.execute( ExpectNoSegment {} );
     }
 
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.send_capacity = 100000;
+
+      TCPSenderTestHarness test { "Scaled window is respected", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4096 ) ); // the SYN's window isn't scaled
+      test.execute( SetWindowShift { 4 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4096 ) );
+      test.execute( Push { string( 70000, 'x' ) } );
+      for ( uint32_t i = 0; i < 65; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + i * 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 536 ).with_seqno( isn + 65001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 65537 } }.with_win( 4096 ) );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 65537 + i * 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 464 ).with_seqno( isn + 69537 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
     {
       TCPConfig cfg;
       const Wrap32 isn( rd() );
@@ -10,6 +10,7 @@
 #include <optional>
 #include <queue>
 #include <sstream>
+#include <string>
 #include <utility>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
@@ -80,6 +81,54 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, u
   uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.consecutive_retransmissions(); }
 };
 
+struct ExpectCwnd : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "cwnd"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.cwnd(); }
+};
+
+struct ExpectSRTT : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "srtt_us"; }
+  uint64_t value( SenderAndOutput& ss ) const override
+  {
+    if ( not ss.sender.srtt_us().has_value() ) {
+      throw ExpectationViolation( "TCPSender has no RTT estimate" );
+    }
+    return ss.sender.srtt_us().value();
+  }
+};
+
+struct ExpectRTO : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "RTO_us"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.RTO_us(); }
+};
+
+struct ExpectInRecovery : public ExpectBool<SenderAndOutput>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "in_recovery"; }
+  bool value( SenderAndOutput& ss ) const override { return ss.sender.in_recovery(); }
+};
+
+struct ExpectMSS : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "mss"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.mss(); }
+};
+
+struct ExpectProbing : public ExpectBool<SenderAndOutput>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "probing"; }
+  bool value( SenderAndOutput& ss ) const override { return ss.sender.probing(); }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput>
 {
   std::string description() const override { return "nothing to send"; }
@@ -97,6 +146,28 @@ struct SetError : public Action<SenderAndOutput>
   void execute( SenderAndOutput& ss ) const override { ss.sender.writer().set_error(); }
 };
 
+struct SetMSS : public Action<SenderAndOutput>
+{
+  uint64_t mss_;
+  uint64_t probe_up_to_;
+
+  explicit SetMSS( uint64_t mss, uint64_t probe_up_to = 0 ) : mss_( mss ), probe_up_to_( probe_up_to ) {}
+  std::string description() const override
+  {
+    return "set_mss(" + std::to_string( mss_ ) + ", " + std::to_string( probe_up_to_ ) + ")";
+  }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_mss( mss_, probe_up_to_ ); }
+};
+
+struct SetWindowShift : public Action<SenderAndOutput>
+{
+  uint8_t shift_;
+
+  explicit SetWindowShift( uint8_t shift ) : shift_( shift ) {}
+  std::string description() const override { return "set_window_shift(" + std::to_string( shift_ ) + ")"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_window_shift( shift_ ); }
+};
+
 struct HasError : public ExpectBool<SenderAndOutput>
 {
   using ExpectBool::ExpectBool;
@@ -183,6 +254,15 @@ struct Tick : public Action<SenderAndOutput>
   }
 };
 
+struct TickMicroseconds : public Action<SenderAndOutput>
+{
+  uint64_t us_;
+
+  explicit TickMicroseconds( uint64_t us ) : us_( us ) {}
+  std::string description() const override { return std::to_string( us_ ) + " us pass"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.tick_us( us_, ss.make_transmit() ); }
+};
+
 struct Receive : public Action<SenderAndOutput>
 {
   TCPReceiverMessage msg_;
@@ -192,7 +272,11 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    if ( not msg_.sack.empty() ) {
+      desc << ", sack=" << to_string( msg_.sack );
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -218,6 +302,12 @@ struct Receive : public Action<SenderAndOutput>
     push_ = false;
     return *this;
   }
+
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.push_back( { left, right } );
+    return *this;
+  }
 };
 
 struct AckReceived : public Receive
@@ -235,6 +325,7 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   std::optional<bool> syn {};
   std::optional<bool> fin {};
   std::optional<bool> rst {};
+  std::optional<bool> sack_permitted {};
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
@@ -263,6 +354,12 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     return *this;
   }
 
+  ExpectMessage& with_sack_permitted( bool sack_permitted_ )
+  {
+    sack_permitted = sack_permitted_;
+    return *this;
+  }
+
   ExpectMessage& with_seqno( Wrap32 seqno_ )
   {
     seqno = seqno_;
@@ -308,6 +405,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() ) {
       o << ( rst.value() ? " +RST" : " (no RST)" );
     }
+    if ( sack_permitted.has_value() ) {
+      o << ( sack_permitted.value() ? " +SACK_permitted" : " (no SACK_permitted)" );
+    }
     return o.str();
   }
 
@@ -334,17 +434,21 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() and seg.RST != rst.value() ) {
       throw ExpectationViolation( "RST flag", rst.value(), seg.RST );
     }
+    if ( sack_permitted.has_value() and seg.SACK_permitted != sack_permitted.value() ) {
+      throw ExpectationViolation( "SACK_permitted flag", sack_permitted.value(), seg.SACK_permitted );
+    }
     if ( seqno.has_value() and seg.seqno != seqno.value() ) {
       throw ExpectationViolation( "sequence number", seqno.value(), seg.seqno );
     }
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    // (a path MTU probe is the one segment that may be larger than the MSS)
+    if ( seg.payload.size() > ss.sender.mss() and not ss.sender.probing() ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
-    if ( data.has_value() and data.value() != static_cast<std::string>( seg.payload ) ) {
+    if ( data.has_value() and data.value() != seg.payload.view() ) {
       throw ExpectationViolation( "Expecting payload of \"" + Printer::prettify( data.value() )
                                   + "\", but instead it was \"" + Printer::prettify( seg.payload ) + "\"" );
     }
@@ -356,9 +460,49 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
 class TCPSenderTestHarness : public TestHarness<SenderAndOutput>
 {
 public:
-  TCPSenderTestHarness( std::string name, TCPConfig config )
+  // Only the receiver's window limits the sender under test, unless a congestion controller is
+  // given, its RTO stays at config.rt_timeout unless RTO bounds are given, and it sends short
+  // segments at once unless told otherwise
+  // (config.congestion_control, the rto_* bounds, coalescing and nodelay are ignored)
+  TCPSenderTestHarness( std::string name,
+                        TCPConfig config,
+                        CongestionControl::Algorithm algorithm = CongestionControl::Algorithm::None,
+                        std::optional<TCPSender::RTOBounds> rto_bounds = {},
+                        Coalescing coalescing = Coalescing::Off )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender { ByteStream { config.send_capacity },
+                                 config.isn,
+                                 config.rt_timeout,
+                                 CongestionControl::make( algorithm, TCPConfig::MAX_PAYLOAD_SIZE ),
+                                 rto_bounds,
+                                 coalescing } } )
+    , isn_( config.isn )
   {}
+
+  // Send the SYN and get it acked with a window of `window` bytes, `rtt_us` after it went out
+  void connect( uint16_t window, uint64_t rtt_us = 0 )
+  {
+    execute( Push {} );
+    execute( ExpectMessage {}.with_syn( true ).with_sack_permitted( true ).with_seqno( isn_ ) );
+    if ( rtt_us ) {
+      execute( TickMicroseconds { rtt_us } );
+      execute( ExpectNoSegment {} );
+    }
+    execute( AckReceived { isn_ + 1 }.with_win( window ) );
+  }
+
+  // Connect, then send one-byte segments "a", "b", "c", ... starting at isn + 1
+  void send_bytes( const std::string& bytes )
+  {
+    connect( 1000 );
+    for ( size_t i = 0; i < bytes.size(); ++i ) {
+      execute( Push { bytes.substr( i, 1 ) } );
+      execute( ExpectMessage {}.with_data( bytes.substr( i, 1 ) ).with_seqno( isn_ + 1 + i ) );
+    }
+    execute( ExpectNoSegment {} );
+  }
+
+private:
+  Wrap32 isn_;
 };
@@ -0,0 +1,142 @@
+#include "random.hh"
+#include "spsc_ring.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+void single_thread()
+{
+  SPSCRing ring { 8 };
+
+  test_should_be( ring.push( "abcdef" ), uint64_t { 6 } );
+  test_should_be( ring.push( "ghijk" ), uint64_t { 2 } );
+  test_should_be( ring.available_capacity(), uint64_t { 0 } );
+
+  string out( 5, 0 );
+  test_should_be( ring.pop( out ), uint64_t { 5 } );
+  if ( out != "abcde" ) {
+    throw runtime_error( "Expected to pop \"abcde\", but got \"" + out + "\"" );
+  }
+
+  // wraps around the end of the ring
+  test_should_be( ring.push( "ijklmn" ), uint64_t { 5 } );
+  out.resize( 16 );
+  out.resize( ring.pop( out ) );
+  if ( out != "fghijklm" ) {
+    throw runtime_error( "Expected to pop \"fghijklm\" across the wrap, but got \"" + out + "\"" );
+  }
+
+  test_should_be( ring.is_finished(), false );
+  ring.close();
+  test_should_be( ring.is_finished(), true );
+  test_should_be( ring.reader_closed(), false );
+}
+
+// The consumer can read the bytes in place and release them afterwards
+void peek_and_consume()
+{
+  SPSCRing ring { 8 };
+
+  test_should_be( ring.push( "abcdef" ), uint64_t { 6 } );
+  auto regions = ring.peek_regions();
+  if ( regions[0] != "abcdef" or not regions[1].empty() ) {
+    throw runtime_error( "Expected to peek \"abcdef\" in one region, but got \"" + string( regions[0] ) + "\" and \""
+                         + string( regions[1] ) + "\"" );
+  }
+
+  // peeking frees nothing; consuming does
+  test_should_be( ring.available_capacity(), uint64_t { 2 } );
+  ring.consume( 4 );
+  test_should_be( ring.available_capacity(), uint64_t { 6 } );
+
+  // the data now wraps around the end of the ring
+  test_should_be( ring.push( "ghijk" ), uint64_t { 5 } );
+  regions = ring.peek_regions();
+  if ( regions[0] != "efgh" or regions[1] != "ijk" ) {
+    throw runtime_error( "Expected to peek \"efgh\" and \"ijk\" across the wrap, but got \"" + string( regions[0] )
+                         + "\" and \"" + string( regions[1] ) + "\"" );
+  }
+
+  ring.consume( 5 );
+  string out( 8, 0 );
+  out.resize( ring.pop( out ) );
+  if ( out != "jk" ) {
+    throw runtime_error( "Expected to pop \"jk\" after consuming, but got \"" + out + "\"" );
+  }
+  test_should_be( ring.bytes_buffered(), uint64_t { 0 } );
+}
+
+// The consumer sleeps on an empty ring and the producer on a full one, so both wakeup paths run.
+void two_threads( const size_t input_len, const size_t capacity )
+{
+  const string data = [&] {
+    auto rd = get_random_engine();
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCRing ring { capacity };
+
+  thread producer( [&] {
+    auto rd = get_random_engine();
+    uniform_int_distribution<size_t> chunk { 1, capacity * 2 };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      const auto bytes_pushed = ring.push( string_view { data }.substr( pushed, chunk( rd ) ) );
+      if ( bytes_pushed == 0 ) {
+        ring.prepare_wait_for_space();
+        SPSCRing::wait( ring.space_event() );
+      }
+      pushed += bytes_pushed;
+    }
+    ring.close();
+  } );
+
+  string output;
+  string buffer;
+  while ( true ) {
+    buffer.resize( capacity );
+    const bool closed = ring.is_closed();
+    buffer.resize( ring.pop( buffer ) );
+    if ( not buffer.empty() ) {
+      output += buffer;
+    } else if ( closed ) {
+      break;
+    } else {
+      ring.prepare_wait_for_data();
+      SPSCRing::wait( ring.data_event() );
+    }
+  }
+  producer.join();
+
+  if ( output != data ) {
+    throw runtime_error( "Mismatch between data pushed and popped (capacity=" + to_string( capacity ) + ")" );
+  }
+}
+
+int main()
+{
+  try {
+    single_thread();
+    peek_and_consume();
+    two_threads( 1 << 20, 7 );
+    two_threads( 1 << 22, 4096 );
+    two_threads( 1 << 22, 65536 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+#include "ipv4_header.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// What the peer at the other end gets: the message, serialized and parsed again
+TCPMessage on_the_wire( TCPMessage msg )
+{
+  TCPSegment seg { .message = std::move( msg ), .udinfo = {} };
+  seg.compute_checksum( 0 );
+  TCPSegment parsed;
+  if ( not parse( parsed, to_slices( serialize( seg ) ), 0 ) ) {
+    throw runtime_error( "Expected the serialized segment to parse" );
+  }
+  return std::move( parsed.message );
+}
+
+struct Transfer
+{
+  vector<TCPMessage> client_sent {}; // the client's segments, as sent
+  vector<TCPMessage> server_sent {};
+  uint64_t largest_window {}; // the largest window the client's sender has seen
+};
+
+// The client connects to the server and sends it `size` bytes over a lossless link with no delay
+Transfer transfer( TCPPeer& client, TCPPeer& server, uint64_t size )
+{
+  Transfer result;
+  deque<TCPMessage> to_server;
+  deque<TCPMessage> to_client;
+  const auto client_transmit = [&]( TCPMessage msg ) {
+    result.client_sent.push_back( msg );
+    to_server.push_back( on_the_wire( std::move( msg ) ) );
+  };
+  const auto server_transmit = [&]( TCPMessage msg ) {
+    result.server_sent.push_back( msg );
+    to_client.push_back( on_the_wire( std::move( msg ) ) );
+  };
+
+  uint64_t written = 0;
+  uint64_t read = 0;
+  for ( int step = 0; step < 100'000 and read < size; ++step ) {
+    Writer& writer = client.outbound_writer();
+    const uint64_t len = min( writer.available_capacity(), size - written );
+    writer.push( string( len, 'x' ) );
+    written += len;
+    client.push( client_transmit );
+
+    while ( not to_server.empty() or not to_client.empty() ) {
+      while ( not to_server.empty() ) {
+        server.receive( std::move( to_server.front() ), server_transmit );
+        to_server.pop_front();
+      }
+      while ( not to_client.empty() ) {
+        client.receive( std::move( to_client.front() ), client_transmit );
+        to_client.pop_front();
+        result.largest_window = max( result.largest_window, client.sender().window_size() );
+      }
+    }
+
+    Reader& reader = server.inbound_reader();
+    read += reader.bytes_buffered();
+    reader.pop( reader.bytes_buffered() );
+
+    client.tick( 1, client_transmit );
+    server.tick( 1, server_transmit );
+  }
+
+  test_should_be( read, size ); // every byte arrives
+  return result;
+}
+
+// Every segment either side sent, options included, fits in an IPv4 datagram no larger than `mtu`
+void check_fits( const Transfer& t, size_t mtu )
+{
+  for ( const auto* sent : { &t.client_sent, &t.server_sent } ) {
+    for ( const auto& msg : *sent ) {
+      TCPSegment seg { .message = msg, .udinfo = {} };
+      const size_t length = IPv4Header::LENGTH + seg.header_length() + msg.sender.payload.size();
+      if ( length > mtu ) {
+        throw runtime_error( "Expected every datagram to fit in " + to_string( mtu ) + " bytes, but one took "
+                             + to_string( length ) );
+      }
+    }
+  }
+}
+
+TCPConfig config( size_t capacity, size_t mtu )
+{
+  TCPConfig cfg;
+  cfg.send_capacity = capacity;
+  cfg.recv_capacity = capacity;
+  cfg.mtu = mtu;
+  return cfg;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // both ends take 16 MB windows and jumbo frames
+      TCPPeer client { config( 16 << 20, 9000 ) };
+      TCPPeer server { config( 16 << 20, 9000 ) };
+      const Transfer t = transfer( client, server, 8 << 20 );
+
+      const TCPSenderMessage& syn = t.client_sent.front().sender;
+      test_should_be( syn.SYN, true );
+      test_should_be( syn.MSS.value_or( 0 ), uint16_t { 8960 } );
+      test_should_be( syn.window_scale.value_or( 0 ), uint8_t { 9 } );
+      test_should_be( t.client_sent.front().receiver.window_size, uint16_t { UINT16_MAX } ); // the SYN's isn't scaled
+      const TCPMessage& syn_ack = t.server_sent.front();
+      test_should_be( syn_ack.sender.SYN, true );
+      test_should_be( syn_ack.sender.window_scale.value_or( 0 ), uint8_t { 9 } );
+      test_should_be( syn_ack.receiver.window_size, uint16_t { UINT16_MAX } );
+
+      test_should_be( server.receiver().window_shift(), uint8_t { 9 } );
+      if ( t.largest_window <= UINT16_MAX ) {
+        throw runtime_error( "Expected the client to see windows past 64 KB, but the largest was "
+                             + to_string( t.largest_window ) );
+      }
+      // the client's segments grew to jumbo size
+      test_should_be( client.sender().mss(), uint64_t { 8960 } );
+      check_fits( t, 9000 );
+    }
+
+    {
+      // a server without window scaling doesn't offer it back, and the windows stay unscaled
+      TCPConfig server_config = config( 16 << 20, 1500 );
+      server_config.window_scaling = false;
+      TCPPeer client { config( 16 << 20, 9000 ) };
+      TCPPeer server { server_config };
+      const Transfer t = transfer( client, server, 1 << 20 );
+
+      test_should_be( t.client_sent.front().sender.window_scale.has_value(), true );
+      test_should_be( t.server_sent.front().sender.window_scale.has_value(), false );
+      test_should_be( server.receiver().window_shift(), uint8_t { 0 } );
+      test_should_be( client.receiver().window_shift(), uint8_t { 0 } );
+      test_should_be( t.largest_window, uint64_t { UINT16_MAX } ); // the window stops at 64 KB
+      test_should_be( client.sender().mss(), uint64_t { 1460 } ); // no larger than the server accepts
+      check_fits( t, 1500 );
+    }
+
+    {
+      // without SACK blocks to send, a full-size segment fills the MTU with payload
+      TCPConfig cfg = config( 1 << 20, 1500 );
+      cfg.mtu_probing = false;
+      TCPPeer client { cfg };
+      TCPPeer server { cfg };
+      const Transfer t = transfer( client, server, 1 << 16 );
+
+      size_t largest_payload = 0;
+      for ( const auto& msg : t.client_sent ) {
+        test_should_be( msg.receiver.sack.size(), size_t { 0 } );
+        largest_payload = max( largest_payload, msg.sender.payload.size() );
+      }
+      test_should_be( largest_payload, size_t { 1500 - TCPConfig::HEADERS_SIZE } );
+      check_fits( t, 1500 );
+
+      // the server's second segment arrives without its first: the client's segments carry a SACK block
+      // now, and their payloads shrink to make room for it
+      Transfer after;
+      const auto client_transmit = [&]( TCPMessage msg ) { after.client_sent.push_back( std::move( msg ) ); };
+      const auto server_transmit = [&]( TCPMessage msg ) { after.server_sent.push_back( std::move( msg ) ); };
+      server.outbound_writer().push( string( 2 * ( 1500 - TCPConfig::HEADERS_SIZE ), 'y' ) );
+      server.push( server_transmit );
+      test_should_be( after.server_sent.size(), size_t { 2 } );
+      client.receive( on_the_wire( after.server_sent.at( 1 ) ), client_transmit );
+
+      client.outbound_writer().push( string( 3000, 'x' ) );
+      client.push( client_transmit );
+      const TCPMessage& data = after.client_sent.back();
+      test_should_be( data.receiver.sack.size(), size_t { 1 } );
+      test_should_be( data.sender.payload.size(), size_t { 1500 - TCPConfig::HEADERS_SIZE - 12 } );
+      check_fits( after, 1500 );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
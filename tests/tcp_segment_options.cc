@@ -0,0 +1,143 @@
+#include "checksum.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+TCPSegment round_trip( const TCPSegment& seg )
+{
+  TCPSegment ret;
+  if ( not parse( ret, to_slices( serialize( seg ) ), 0 ) ) {
+    throw runtime_error( "Expected the serialized segment to parse" );
+  }
+  return ret;
+}
+
+string concat( const vector<string>& buffers )
+{
+  string ret;
+  for ( const auto& b : buffers ) {
+    ret += b;
+  }
+  return ret;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      TCPSegment seg;
+      seg.message.sender.SYN = true;
+      seg.message.sender.SACK_permitted = true;
+      seg.compute_checksum( 0 );
+      test_should_be( seg.header_length(), size_t { 24 } ); // SACK-permitted takes one word
+      const auto parsed = round_trip( seg );
+      test_should_be( parsed.message.sender.SYN, true );
+      test_should_be( parsed.message.sender.SACK_permitted, true );
+    }
+
+    {
+      TCPSegment seg;
+      seg.message.sender.SYN = true;
+      seg.message.sender.SACK_permitted = true;
+      seg.message.sender.MSS = 8960;
+      seg.compute_checksum( 0 );
+      test_should_be( seg.header_length(), size_t { 28 } ); // MSS takes one word
+      const auto parsed = round_trip( seg );
+      test_should_be( parsed.message.sender.MSS.value_or( 0 ), uint16_t { 8960 } );
+      test_should_be( parsed.message.sender.SACK_permitted, true );
+
+      seg.message.sender.window_scale = 7;
+      seg.compute_checksum( 0 );
+      test_should_be( seg.header_length(), size_t { 32 } ); // window scale takes one word
+      const auto scaled = round_trip( seg );
+      test_should_be( scaled.message.sender.window_scale.value_or( 0 ), uint8_t { 7 } );
+      test_should_be( scaled.message.sender.MSS.value_or( 0 ), uint16_t { 8960 } );
+
+      // only a SYN carries them
+      seg.message.sender.SYN = false;
+      seg.compute_checksum( 0 );
+      test_should_be( seg.header_length(), size_t { 20 } );
+      test_should_be( round_trip( seg ).message.sender.MSS.has_value(), false );
+      test_should_be( round_trip( seg ).message.sender.window_scale.has_value(), false );
+    }
+
+    {
+      TCPSegment seg;
+      seg.message.receiver.ackno = Wrap32 { 1000 };
+      seg.message.receiver.sack = { { Wrap32 { 2000 }, Wrap32 { 3000 } }, { Wrap32 { 1500 }, Wrap32 { 1600 } } };
+      seg.message.sender.payload = "hello";
+      seg.compute_checksum( 0 );
+      test_should_be( seg.header_length(), size_t { 40 } ); // two SACK blocks take 5 words
+      const auto parsed = round_trip( seg );
+      if ( parsed.message.receiver.sack != seg.message.receiver.sack ) {
+        throw runtime_error( "Expected " + to_string( seg.message.receiver.sack ) + " SACK blocks, but parsed "
+                             + to_string( parsed.message.receiver.sack ) );
+      }
+      if ( parsed.message.sender.payload != "hello" ) {
+        throw runtime_error( "Expected the payload \"hello\" after the options" );
+      }
+    }
+
+    {
+      // no more blocks than fit in the header
+      TCPSegment seg;
+      seg.message.receiver.ackno = Wrap32 { 0 };
+      seg.message.receiver.sack.assign( 6, { Wrap32 { 10 }, Wrap32 { 20 } } );
+      seg.compute_checksum( 0 );
+      test_should_be( seg.header_length(), size_t { 56 } ); // four SACK blocks take 9 words
+      test_should_be( round_trip( seg ).message.receiver.sack.size(), size_t { 4 } );
+    }
+
+    {
+      // unknown options (here a timestamp, then the end of the list) are skipped
+      TCPSegment seg;
+      seg.message.sender.payload = "x";
+      string raw = concat( serialize( seg ) );
+      raw.insert( 20, string( "\x08\x0a\x00\x00\x00\x01\x00\x00\x00\x02\x00\x00", 12 ) );
+      raw[12] = static_cast<char>( ( 5 + 3 ) << 4 ); // data offset
+      InternetChecksum check;
+      check.add( raw );
+      raw[16] = static_cast<char>( check.value() >> 8 );
+      raw[17] = static_cast<char>( check.value() & 0xff );
+
+      TCPSegment parsed;
+      test_should_be( parse( parsed, { raw }, 0 ), true );
+      if ( parsed.message.sender.payload != "x" ) {
+        throw runtime_error( "Expected the payload \"x\" after the options" );
+      }
+      test_should_be( parsed.message.receiver.sack.empty(), true );
+      test_should_be( parsed.message.sender.SACK_permitted, false );
+    }
+
+    {
+      // an option that runs past the header is an error
+      string raw = concat( serialize( TCPSegment {} ) );
+      raw.insert( 20, string( "\x05\x0a\x00\x00", 4 ) );
+      raw[12] = static_cast<char>( ( 5 + 1 ) << 4 );
+      InternetChecksum check;
+      check.add( raw );
+      raw[16] = static_cast<char>( check.value() >> 8 );
+      raw[17] = static_cast<char>( check.value() & 0xff );
+
+      TCPSegment parsed;
+      test_should_be( parse( parsed, { raw }, 0 ), false );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
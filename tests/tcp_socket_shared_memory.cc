@@ -0,0 +1,149 @@
+#include "random.hh"
+#include "socket.hh"
+#include "tcp_minnow_socket_impl.hh"
+#include "tcp_over_ip.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Carries the IPv4 datagrams between the two sockets over a connected pair of loopback UDP sockets
+class LoopbackAdapter : public TCPOverIPv4Adapter
+{
+  UDPSocket socket_;
+
+public:
+  explicit LoopbackAdapter( UDPSocket&& socket ) : socket_( std::move( socket ) ) {}
+
+  optional<TCPMessage> read()
+  {
+    vector<string> strs( 2 );
+    strs.front().resize( IPv4Header::LENGTH );
+    socket_.read( strs );
+
+    InternetDatagram ip_dgram;
+    if ( parse( ip_dgram, to_slices( std::move( strs ) ) ) ) {
+      return unwrap_tcp_in_ip( ip_dgram );
+    }
+    return {};
+  }
+
+  void write( const TCPMessage& msg ) { socket_.write( serialize( wrap_tcp_in_ip( msg ) ) ); }
+
+  FileDescriptor& fd() { return socket_; }
+};
+
+using LoopbackSocket = TCPMinnowSocket<LoopbackAdapter>;
+
+string random_string( size_t len )
+{
+  auto rd = get_random_engine();
+  uniform_int_distribution<char> ud;
+  string ret;
+  ret.reserve( len );
+  for ( size_t i = 0; i < len; ++i ) {
+    ret.push_back( ud( rd ) );
+  }
+  return ret;
+}
+
+// Write `data` in pieces of varying size, then end the stream
+void write_all( LoopbackSocket& sock, string_view data )
+{
+  auto rd = get_random_engine();
+  uniform_int_distribution<size_t> piece { 1, 100'000 };
+  while ( not data.empty() ) {
+    data.remove_prefix( sock.write_shared( data.substr( 0, piece( rd ) ) ) );
+  }
+  sock.shutdown_shared_write();
+}
+
+string read_all( LoopbackSocket& sock )
+{
+  string received;
+  string buffer;
+  while ( not sock.eof() ) {
+    buffer.clear();
+    sock.read_shared( buffer );
+    received.append( buffer );
+  }
+  return received;
+}
+
+// Each side sends the other a few megabytes at once, so all four rings fill and drain
+void exchange( const size_t client_len, const size_t server_len )
+{
+  UDPSocket client_udp;
+  UDPSocket server_udp;
+  client_udp.bind( Address { "127.0.0.1", 0 } );
+  server_udp.bind( Address { "127.0.0.1", 0 } );
+  client_udp.connect( server_udp.local_address() );
+  server_udp.connect( client_udp.local_address() );
+
+  LoopbackSocket client { LoopbackAdapter { std::move( client_udp ) } };
+  LoopbackSocket server { LoopbackAdapter { std::move( server_udp ) } };
+  client.use_shared_memory();
+  server.use_shared_memory();
+
+  TCPConfig cfg;
+  cfg.rt_timeout = 100;
+
+  FdAdapterConfig client_addresses;
+  client_addresses.source = { "169.254.144.1", "4000" };
+  client_addresses.destination = { "169.254.144.2", "5000" };
+  FdAdapterConfig server_addresses;
+  server_addresses.source = { "169.254.144.2", "5000" };
+
+  const string to_server = random_string( client_len );
+  const string to_client = random_string( server_len );
+  string server_received;
+
+  thread server_thread( [&] {
+    server.listen_and_accept( cfg, server_addresses );
+    thread writer( [&] { write_all( server, to_client ); } );
+    server_received = read_all( server );
+    writer.join();
+    server.wait_until_closed();
+  } );
+
+  client.connect( cfg, client_addresses );
+  thread writer( [&] { write_all( client, to_server ); } );
+  const string client_received = read_all( client );
+  writer.join();
+  client.wait_until_closed();
+  server_thread.join();
+
+  test_should_be( server_received.size(), to_server.size() );
+  test_should_be( client_received.size(), to_client.size() );
+  if ( server_received != to_server or client_received != to_client ) {
+    throw runtime_error( "bytes were corrupted on the way through the rings" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    exchange( 4'000'000, 3'000'000 );
+    exchange( 0, 1'000'000 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "buffer_pool.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+BufferPool& BufferPool::global()
+{
+  static BufferPool pool;
+  return pool;
+}
+
+void BufferPool::configure( const size_t slab_size, const size_t max_slabs )
+{
+  const lock_guard lock { mutex_ };
+  if ( stats_.slabs_in_use ) {
+    throw runtime_error( "BufferPool::configure() while slabs are in use" );
+  }
+  if ( slab_size == 0 ) {
+    throw runtime_error( "BufferPool::configure() with zero slab size" );
+  }
+
+  stats_ = { .slab_size = slab_size, .max_slabs = max_slabs };
+  arena_.reset();
+  free_.clear();
+  never_used_ = 0;
+}
+
+size_t BufferPool::slab_size() const
+{
+  const lock_guard lock { mutex_ };
+  return stats_.slab_size;
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+  const lock_guard lock { mutex_ };
+  return stats_;
+}
+
+BufferPool::Slab BufferPool::borrow()
+{
+  const lock_guard lock { mutex_ };
+
+  size_t index {};
+  if ( not free_.empty() ) {
+    index = free_.back();
+    free_.pop_back();
+  } else if ( never_used_ < stats_.max_slabs ) {
+    if ( not arena_ ) {
+      // untouched pages of the arena don't cost any memory until they are written
+      arena_ = make_unique_for_overwrite<char[]>( stats_.max_slabs * stats_.slab_size ); // NOLINT(*-c-arrays)
+    }
+    index = never_used_++;
+  } else {
+    ++stats_.allocation_failures;
+    return { this, new char[stats_.slab_size], stats_.slab_size }; // NOLINT(*-owning-memory)
+  }
+
+  ++stats_.slabs_in_use;
+  stats_.high_water_mark = max( stats_.high_water_mark, stats_.slabs_in_use );
+  return { this, arena_.get() + index * stats_.slab_size, stats_.slab_size };
+}
+
+void BufferPool::release( char* data )
+{
+  const lock_guard lock { mutex_ };
+
+  if ( arena_ and data >= arena_.get() and data < arena_.get() + stats_.max_slabs * stats_.slab_size ) {
+    free_.push_back( ( data - arena_.get() ) / stats_.slab_size );
+    --stats_.slabs_in_use;
+  } else {
+    delete[] data; // NOLINT(*-owning-memory)
+  }
+}
+
+BufferPool::Slab::~Slab()
+{
+  if ( data_ ) {
+    pool_->release( data_ );
+  }
+}
+
+BufferPool::Slab::Slab( const Slab& other )
+{
+  if ( other.data_ ) {
+    *this = other.pool_->borrow();
+    memcpy( data_, other.data_, size_ );
+  }
+}
+
+BufferPool::Slab& BufferPool::Slab::operator=( const Slab& other )
+{
+  if ( this != &other ) {
+    Slab copy { other };
+    swap( copy );
+  }
+  return *this;
+}
+
+BufferPool::Slab::Slab( Slab&& other ) noexcept
+{
+  swap( other );
+}
+
+BufferPool::Slab& BufferPool::Slab::operator=( Slab&& other ) noexcept
+{
+  Slab moved { std::move( other ) };
+  swap( moved );
+  return *this;
+}
+
+void BufferPool::Slab::swap( Slab& other ) noexcept
+{
+  std::swap( pool_, other.pool_ );
+  std::swap( data_, other.data_ );
+  std::swap( size_, other.size_ );
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//! \brief A process-wide pool of fixed-size buffer slabs
+//!
+//! The pool carves its slabs out of one arena (reserved on first use), so streams that borrow and
+//! return slabs as data comes and goes don't churn or fragment the heap. When every slab is in use,
+//! a borrower gets a slab from the heap instead; this is counted as an allocation failure.
+class BufferPool
+{
+public:
+  static constexpr size_t DEFAULT_SLAB_SIZE = 16384; //!< 16 KiB
+  static constexpr size_t DEFAULT_MAX_SLABS = 4096;  //!< 64 MiB of slabs in total
+
+  struct Stats
+  {
+    size_t slab_size {};
+    size_t max_slabs {};
+    size_t slabs_in_use {};          //!< Slabs currently borrowed from the arena
+    size_t high_water_mark {};       //!< Most slabs ever borrowed from the arena at once
+    uint64_t allocation_failures {}; //!< Borrows that found the arena exhausted
+  };
+
+  //! A borrowed slab, returned to its pool on destruction. Copies borrow a slab of their own.
+  class Slab
+  {
+  public:
+    Slab() = default;
+    ~Slab();
+    Slab( const Slab& other );
+    Slab& operator=( const Slab& other );
+    Slab( Slab&& other ) noexcept;
+    Slab& operator=( Slab&& other ) noexcept;
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    friend class BufferPool;
+    Slab( BufferPool* pool, char* data, size_t size ) : pool_( pool ), data_( data ), size_( size ) {}
+    void swap( Slab& other ) noexcept;
+
+    BufferPool* pool_ {};
+    char* data_ {};
+    size_t size_ {};
+  };
+
+  BufferPool() = default;
+
+  //! The pool used by ByteStream's pooled storage
+  static BufferPool& global();
+
+  //! Change the slab size and the number of slabs (only while no slab is borrowed)
+  void configure( size_t slab_size, size_t max_slabs );
+
+  size_t slab_size() const;
+  Slab borrow();
+  Stats stats() const;
+
+  // The pool hands out pointers into itself, so it can't be copied or moved
+  BufferPool( const BufferPool& other ) = delete;
+  BufferPool& operator=( const BufferPool& other ) = delete;
+  BufferPool( BufferPool&& other ) = delete;
+  BufferPool& operator=( BufferPool&& other ) = delete;
+  ~BufferPool() = default;
+
+private:
+  void release( char* data );
+
+  mutable std::mutex mutex_ {};
+  Stats stats_ { .slab_size = DEFAULT_SLAB_SIZE, .max_slabs = DEFAULT_MAX_SLABS };
+  std::unique_ptr<char[]> arena_ {}; // NOLINT(*-avoid-c-arrays)
+  std::vector<size_t> free_ {};      //!< Indices of free arena slabs (most recently freed last)
+  size_t never_used_ {};             //!< Slabs past this index have never been handed out
+};
@@ -0,0 +1,32 @@
+#include "buffer_slice.hh"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+BufferSlice::BufferSlice( string str )
+  : buffer_( make_shared<const string>( move( str ) ) ), view_( *buffer_ )
+{}
+
+BufferSlice BufferSlice::substr( size_t pos, size_t len ) const
+{
+  BufferSlice ret { *this };
+  ret.view_ = view_.substr( pos, len );
+  return ret;
+}
+
+void BufferSlice::shrink_to_fit()
+{
+  if ( buffer_ and buffer_->capacity() > 2 * size() ) {
+    *this = BufferSlice { string { view_ } };
+  }
+}
+
+vector<BufferSlice> to_slices( vector<string> buffers )
+{
+  vector<BufferSlice> ret;
+  ret.reserve( buffers.size() );
+  ranges::move( buffers, back_inserter( ret ) );
+  return ret;
+}
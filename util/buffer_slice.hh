@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! An immutable slice of a reference-counted buffer
+//!
+//! Copying or narrowing a slice shares the bytes instead of copying them, so a payload can go from
+//! the read() that received it, through the parsers, to the Reassembler without being copied; the
+//! buffer is freed when the last slice of it is gone.
+class BufferSlice
+{
+public:
+  BufferSlice() = default;
+
+  //! Take ownership of `str` (implicit, so a string can stand wherever a slice is expected)
+  BufferSlice( std::string str ); // NOLINT(*-explicit-*)
+  BufferSlice( const char* str ) : BufferSlice( std::string { str } ) {} // NOLINT(*-explicit-*)
+
+  std::string_view view() const { return view_; }
+  operator std::string_view() const { return view_; } // NOLINT(*-explicit-*)
+
+  const char* data() const { return view_.data(); }
+  size_t size() const { return view_.size(); }
+  bool empty() const { return view_.empty(); }
+
+  //! A narrower slice of the same buffer
+  BufferSlice substr( size_t pos, size_t len = std::string_view::npos ) const;
+
+  void remove_prefix( size_t n ) { view_.remove_prefix( n ); }
+  void remove_suffix( size_t n ) { view_.remove_suffix( n ); }
+
+  //! Copy the bytes into a buffer of their own if they are holding on to a much larger one
+  //! (say, a short payload that is kept for a while, out of a whole read buffer)
+  void shrink_to_fit();
+
+  bool operator==( std::string_view other ) const { return view_ == other; }
+
+private:
+  std::shared_ptr<const std::string> buffer_ {};
+  std::string_view view_ {};
+};
+
+//! Wrap each of `buffers` in a slice of its own (taking, not copying, the bytes)
+std::vector<BufferSlice> to_slices( std::vector<std::string> buffers );
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "buffer_slice.hh"
 #include "ethernet_header.hh"
 #include "parser.hh"
 
@@ -8,7 +9,7 @@
 struct EthernetFrame
 {
   EthernetHeader header {};
-  std::vector<std::string> payload {};
+  std::vector<BufferSlice> payload {};
 
   void parse( Parser& parser )
   {
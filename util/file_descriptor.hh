@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,6 +66,10 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into caller-owned memory, filling `buffers` in order (with a single readv)
+  // returns number of bytes read
+  size_t read( const std::vector<std::span<char>>& buffers );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
@@ -83,6 +88,9 @@ public:
   // Size of file
   off_t size() const;
 
+  // Bytes a read would return right now ([FIONREAD](\ref man2::ioctl)), or 0 if the kernel can't tell
+  size_t bytes_readable() const;
+
   // FDWrapper accessors
   int fd_num() const { return internal_fd_->fd_; }                        // underlying descriptor number
   bool eof() const { return internal_fd_->eof_; }                         // EOF flag state
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "buffer_slice.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
 
@@ -11,7 +12,7 @@
 struct IPv4Datagram
 {
   IPv4Header header {};
-  std::vector<std::string> payload {};
+  std::vector<BufferSlice> payload {};
 
   void parse( Parser& parser )
   {
@@ -22,9 +23,7 @@ struct IPv4Datagram
   void serialize( Serializer& serializer ) const
   {
     header.serialize( serializer );
-    for ( const auto& x : payload ) {
-      serializer.buffer( x );
-    }
+    serializer.buffer( payload );
   }
 };
 
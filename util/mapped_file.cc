@@ -0,0 +1,42 @@
+#include "mapped_file.hh"
+#include "exception.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+MappedFile::MappedFile( const FileDescriptor& fd )
+{
+  struct stat st {};
+  CheckSystemCall( "fstat", fstat( fd.fd_num(), &st ) );
+  if ( not S_ISREG( st.st_mode ) ) {
+    throw runtime_error( "MappedFile: not a regular file" );
+  }
+
+  size_ = static_cast<uint64_t>( st.st_size );
+  if ( size_ == 0 ) {
+    return; // mmap refuses empty mappings
+  }
+
+  void* const mapping = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd.fd_num(), 0 );
+  if ( mapping == MAP_FAILED ) {
+    throw unix_error( "mmap" );
+  }
+  data_ = static_cast<const char*>( mapping );
+
+  // the payload is read front to back, once
+  madvise( mapping, size_, MADV_SEQUENTIAL );
+}
+
+MappedFile::MappedFile( const string& path )
+  : MappedFile( FileDescriptor { CheckSystemCall( "open " + path, open( path.c_str(), O_RDONLY | O_CLOEXEC ) ) } )
+{}
+
+MappedFile::~MappedFile()
+{
+  if ( data_ ) {
+    munmap( const_cast<char*>( data_ ), size_ );
+  }
+}
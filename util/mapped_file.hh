@@ -0,0 +1,32 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <cstdint>
+#include <string_view>
+
+//! A read-only memory mapping of a whole file
+//!
+//! Byte streams can hold slices of the mapping by reference (see Writer::push_file), so the
+//! mapping is usually owned through a std::shared_ptr and unmapped when the last slice is gone.
+class MappedFile
+{
+public:
+  //! Map the regular file open as `fd` (which may be closed afterwards)
+  explicit MappedFile( const FileDescriptor& fd );
+
+  //! Open and map the file at `path`
+  explicit MappedFile( const std::string& path );
+
+  ~MappedFile();
+
+  MappedFile( const MappedFile& other ) = delete;
+  MappedFile& operator=( const MappedFile& other ) = delete;
+
+  std::string_view view() const { return { data_, size_ }; }
+  uint64_t size() const { return size_; }
+
+private:
+  const char* data_ {};
+  uint64_t size_ {};
+};
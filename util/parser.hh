@@ -1,5 +1,7 @@
 #pragma once
 
+#include "buffer_slice.hh"
+
 #include <algorithm>
 #include <concepts>
 #include <cstdint>
@@ -17,14 +19,13 @@ class Parser
   class BufferList
   {
     uint64_t size_ {};
-    std::deque<std::string> buffer_ {};
-    uint64_t skip_ {};
+    std::deque<BufferSlice> buffer_ {};
 
   public:
-    explicit BufferList( const std::vector<std::string>& buffers )
+    explicit BufferList( std::vector<BufferSlice> buffers )
     {
-      for ( const auto& x : buffers ) {
-        append( x );
+      for ( auto& x : buffers ) {
+        append( std::move( x ) );
       }
     }
 
@@ -37,72 +38,54 @@ class Parser
       if ( buffer_.empty() ) {
         throw std::runtime_error( "peek on empty BufferList" );
       }
-      return std::string_view { buffer_.front() }.substr( skip_ );
+      return buffer_.front();
     }
 
     void remove_prefix( uint64_t len )
     {
       while ( len and not buffer_.empty() ) {
-        const uint64_t to_pop_now = std::min( len, peek().size() );
-        skip_ += to_pop_now;
+        const uint64_t to_pop_now = std::min( len, buffer_.front().size() );
+        buffer_.front().remove_prefix( to_pop_now );
         len -= to_pop_now;
         size_ -= to_pop_now;
-        if ( skip_ == buffer_.front().size() ) {
+        if ( buffer_.front().empty() ) {
           buffer_.pop_front();
-          skip_ = 0;
         }
       }
     }
 
-    void dump_all( std::vector<std::string>& out )
+    // The remaining buffers are handed over as they are, sharing their bytes
+    void dump_all( std::vector<BufferSlice>& out )
     {
-      out.clear();
-      if ( empty() ) {
-        return;
-      }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
-      out.emplace_back( std::move( first_str ) );
-      buffer_.pop_front();
-      for ( auto&& x : buffer_ ) {
-        out.emplace_back( std::move( x ) );
-      }
+      out.assign( std::make_move_iterator( buffer_.begin() ), std::make_move_iterator( buffer_.end() ) );
+      buffer_.clear();
+      size_ = 0;
     }
 
-    void dump_all( std::string& out )
+    // Only bytes that straddle several buffers are copied
+    void dump_all( BufferSlice& out )
     {
-      std::vector<std::string> concat;
-      dump_all( concat );
-      if ( concat.size() == 1 ) {
-        out = std::move( concat.front() );
-        return;
-      }
-
-      out.clear();
-      for ( const auto& s : concat ) {
-        out.append( s );
+      if ( buffer_.size() <= 1 ) {
+        out = buffer_.empty() ? BufferSlice {} : std::move( buffer_.front() );
+      } else {
+        std::string concat;
+        concat.reserve( size_ );
+        for ( const auto& x : buffer_ ) {
+          concat.append( x );
+        }
+        out = std::move( concat );
       }
+      buffer_.clear();
+      size_ = 0;
     }
 
-    std::vector<std::string_view> buffer() const
-    {
-      if ( empty() ) {
-        return {};
-      }
-      std::vector<std::string_view> ret;
-      ret.reserve( buffer_.size() );
-      auto tmp_skip = skip_;
-      for ( const auto& x : buffer_ ) {
-        ret.push_back( std::string_view { x }.substr( tmp_skip ) );
-        tmp_skip = 0;
-      }
-      return ret;
-    }
+    std::vector<std::string_view> buffer() const { return { buffer_.begin(), buffer_.end() }; }
 
-    void append( std::string str )
+    void append( BufferSlice str )
     {
+      if ( str.empty() ) {
+        return;
+      }
       size_ += str.size();
       buffer_.push_back( std::move( str ) );
     }
@@ -119,7 +102,7 @@ class Parser
   }
 
 public:
-  explicit Parser( const std::vector<std::string>& input ) : input_( input ) {}
+  explicit Parser( std::vector<BufferSlice> input ) : input_( std::move( input ) ) {}
 
   const BufferList& input() const { return input_; }
 
@@ -164,8 +147,8 @@ public:
     }
   }
 
-  void all_remaining( std::vector<std::string>& out ) { input_.dump_all( out ); }
-  void all_remaining( std::string& out ) { input_.dump_all( out ); }
+  void all_remaining( std::vector<BufferSlice>& out ) { input_.dump_all( out ); }
+  void all_remaining( BufferSlice& out ) { input_.dump_all( out ); }
   std::vector<std::string_view> buffer() const { return input_.buffer(); }
 };
 
@@ -197,6 +180,8 @@ public:
     }
   }
 
+  void buffer( const BufferSlice& buf ) { buffer( std::string { buf.view() } ); }
+
   void buffer( const std::vector<std::string>& bufs )
   {
     for ( const auto& b : bufs ) {
@@ -204,6 +189,13 @@ public:
     }
   }
 
+  void buffer( const std::vector<BufferSlice>& bufs )
+  {
+    for ( const auto& b : bufs ) {
+      buffer( b );
+    }
+  }
+
   void flush()
   {
     if ( not buffer_.empty() ) {
@@ -230,9 +222,9 @@ std::vector<std::string> serialize( const T& obj )
 
 // Helper to parse any object (without constructing a Parser of the caller's own). Returns true if successful.
 template<class T, typename... Targs>
-bool parse( T& obj, const std::vector<std::string>& buffers, Targs&&... Fargs )
+bool parse( T& obj, std::vector<BufferSlice> buffers, Targs&&... Fargs )
 {
-  Parser p { buffers };
+  Parser p { std::move( buffers ) };
   obj.parse( p, std::forward<Targs>( Fargs )... );
   return not p.has_error();
 }
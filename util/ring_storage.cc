@@ -0,0 +1,103 @@
+#include "ring_storage.hh"
+
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+RingStorage::RingStorage( const uint64_t min_size, const bool mirrored )
+{
+  if ( min_size == 0 ) {
+    return;
+  }
+
+  if ( mirrored ) {
+    const auto page_size = static_cast<uint64_t>( sysconf( _SC_PAGESIZE ) );
+    const uint64_t rounded = ( min_size + page_size - 1 ) / page_size * page_size;
+    mapping_ = map_mirrored( rounded );
+    if ( mapping_ ) {
+      size_ = rounded;
+      return;
+    }
+  }
+
+  heap_.resize( min_size );
+  size_ = min_size;
+}
+
+// Reserve 2 * size bytes of address space, then map the same memfd over both halves.
+char* RingStorage::map_mirrored( const uint64_t size )
+{
+#ifdef MFD_CLOEXEC
+  const int fd = memfd_create( "minnow_ring", MFD_CLOEXEC );
+  if ( fd < 0 ) {
+    return nullptr;
+  }
+
+  char* ret = nullptr;
+  if ( ftruncate( fd, static_cast<off_t>( size ) ) == 0 ) {
+    void* base = mmap( nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( base != MAP_FAILED ) {
+      auto* const first = static_cast<char*>( base );
+      const bool ok = mmap( first, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) != MAP_FAILED
+                      and mmap( first + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 )
+                            != MAP_FAILED;
+      if ( ok ) {
+        ret = first;
+      } else {
+        munmap( base, 2 * size );
+      }
+    }
+  }
+
+  close( fd ); // the mappings keep the memory alive
+  return ret;
+#else
+  static_cast<void>( size );
+  return nullptr;
+#endif
+}
+
+RingStorage::~RingStorage()
+{
+  if ( mapping_ ) {
+    munmap( mapping_, 2 * size_ );
+  }
+}
+
+RingStorage::RingStorage( const RingStorage& other ) : RingStorage( other.size_, other.mirrored() )
+{
+  if ( size_ ) {
+    memcpy( data(), other.data(), size_ );
+  }
+}
+
+RingStorage& RingStorage::operator=( const RingStorage& other )
+{
+  if ( this != &other ) {
+    RingStorage copy { other };
+    swap( copy );
+  }
+  return *this;
+}
+
+RingStorage::RingStorage( RingStorage&& other ) noexcept
+{
+  swap( other );
+}
+
+RingStorage& RingStorage::operator=( RingStorage&& other ) noexcept
+{
+  RingStorage moved { std::move( other ) };
+  swap( moved );
+  return *this;
+}
+
+void RingStorage::swap( RingStorage& other ) noexcept
+{
+  std::swap( size_, other.size_ );
+  heap_.swap( other.heap_ );
+  std::swap( mapping_, other.mapping_ );
+}
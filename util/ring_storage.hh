@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//! Backing memory for a circular buffer
+//!
+//! In the plain mode the ring is an ordinary heap allocation. In the mirrored mode the same
+//! memfd pages are mapped twice, back to back, so `data()[i]` and `data()[i + size()]` name the
+//! same byte: any run of up to `size()` bytes starting inside the ring is contiguous in memory.
+class RingStorage
+{
+public:
+  RingStorage() = default;
+
+  //! Allocate at least `min_size` bytes. If `mirrored` is requested but memfd/mmap is not
+  //! available, quietly fall back to plain memory (check `mirrored()` to see what was granted).
+  RingStorage( uint64_t min_size, bool mirrored );
+
+  ~RingStorage();
+
+  //! Copies get their own memory of the same kind and size, with the same contents
+  RingStorage( const RingStorage& other );
+  RingStorage& operator=( const RingStorage& other );
+  RingStorage( RingStorage&& other ) noexcept;
+  RingStorage& operator=( RingStorage&& other ) noexcept;
+
+  char* data() { return mapping_ ? mapping_ : heap_.data(); }
+  const char* data() const { return mapping_ ? mapping_ : heap_.data(); }
+
+  uint64_t size() const { return size_; }               //!< Length of the ring (may exceed the requested size)
+  bool mirrored() const { return mapping_ != nullptr; } //!< Is `data()` followed by a second view of the ring?
+
+  void swap( RingStorage& other ) noexcept;
+
+private:
+  //! Try to map a mirrored ring of `size` bytes (a multiple of the page size); nullptr on failure
+  static char* map_mirrored( uint64_t size );
+
+  uint64_t size_ {};
+  std::string heap_ {}; //!< Plain storage (unused when mirrored)
+  char* mapping_ {};    //!< Start of the 2 * `size_` byte double mapping, or nullptr
+};
@@ -0,0 +1,141 @@
+#include "spsc_ring.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+SPSCRing::SPSCRing( const uint64_t capacity )
+  : capacity_( capacity )
+  , buffer_( capacity, false )
+  , data_event_( CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) )
+  , space_event_( CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) )
+{}
+
+uint64_t SPSCRing::bytes_buffered() const
+{
+  return tail_.load() - head_.load();
+}
+
+uint64_t SPSCRing::available_capacity() const
+{
+  return capacity_ - bytes_buffered();
+}
+
+uint64_t SPSCRing::push( const string_view data )
+{
+  const uint64_t tail = tail_.load( memory_order_relaxed ); // only we write tail_
+  const uint64_t to_push = min( data.size(), capacity_ - ( tail - head_.load( memory_order_acquire ) ) );
+  if ( to_push == 0 ) {
+    return 0;
+  }
+
+  const uint64_t offset = tail % capacity_;
+  const uint64_t first_part = min( to_push, capacity_ - offset );
+  memcpy( buffer_.data() + offset, data.data(), first_part );
+  memcpy( buffer_.data(), data.data() + first_part, to_push - first_part );
+
+  // Publish, then wake the consumer if it went to sleep on an empty ring. Both operations are
+  // sequentially consistent, pairing with prepare_wait_for_data(): either it sees the new tail,
+  // or we see its waiting flag.
+  tail_.store( tail + to_push );
+  if ( reader_waiting_.exchange( false ) ) {
+    notify( data_event_ );
+  }
+  return to_push;
+}
+
+uint64_t SPSCRing::pop( const span<char> out )
+{
+  const auto [first, second] = peek_regions();
+  const uint64_t first_part = min( out.size(), first.size() );
+  const uint64_t second_part = min( out.size() - first_part, second.size() );
+  memcpy( out.data(), first.data(), first_part );
+  memcpy( out.data() + first_part, second.data(), second_part );
+
+  consume( first_part + second_part );
+  return first_part + second_part;
+}
+
+array<string_view, 2> SPSCRing::peek_regions() const
+{
+  const uint64_t head = head_.load( memory_order_relaxed ); // only the consumer writes head_
+  const uint64_t buffered = tail_.load( memory_order_acquire ) - head;
+
+  const uint64_t offset = head % capacity_;
+  const uint64_t first_part = min( buffered, capacity_ - offset );
+  return { string_view { buffer_.data() + offset, first_part },
+           string_view { buffer_.data(), buffered - first_part } };
+}
+
+void SPSCRing::consume( const uint64_t len )
+{
+  if ( len == 0 ) {
+    return;
+  }
+
+  head_.store( head_.load( memory_order_relaxed ) + len );
+  if ( writer_waiting_.exchange( false ) ) {
+    notify( space_event_ );
+  }
+}
+
+void SPSCRing::close()
+{
+  closed_.store( true );
+  notify( data_event_ );
+}
+
+void SPSCRing::close_reader()
+{
+  reader_closed_.store( true );
+  notify( space_event_ );
+}
+
+// If data arrived (or the ring closed) while we were deciding to sleep, fire our own event so the
+// poll returns right away instead of waiting for a wakeup that will never come.
+void SPSCRing::prepare_wait_for_data()
+{
+  reader_waiting_.store( true );
+  if ( bytes_buffered() > 0 or is_closed() ) {
+    if ( reader_waiting_.exchange( false ) ) {
+      notify( data_event_ );
+    }
+  }
+}
+
+void SPSCRing::prepare_wait_for_space()
+{
+  writer_waiting_.store( true );
+  if ( available_capacity() > 0 or reader_closed() ) {
+    if ( writer_waiting_.exchange( false ) ) {
+      notify( space_event_ );
+    }
+  }
+}
+
+// Signal through the raw descriptor: the other thread owns the FileDescriptor's bookkeeping.
+void SPSCRing::notify( const FileDescriptor& event )
+{
+  const uint64_t one = 1;
+  CheckSystemCall( "eventfd write", static_cast<int>( ::write( event.fd_num(), &one, sizeof( one ) ) ) );
+}
+
+void SPSCRing::drain( FileDescriptor& event )
+{
+  string counter( sizeof( uint64_t ), 0 );
+  event.read( counter );
+}
+
+void SPSCRing::wait( FileDescriptor& event )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  CheckSystemCall( "poll", ::poll( &pfd, 1, -1 ) );
+  drain( event );
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "file_descriptor.hh"
+#include "ring_storage.hh"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+//! \brief A lock-free single-producer/single-consumer byte ring shared by two threads
+//!
+//! One thread may only call the producer methods and the other only the consumer methods.
+//! A side that finds the ring empty (or full) calls `prepare_wait_for_data()` (or
+//! `prepare_wait_for_space()`) and then polls `data_event()` (or `space_event()`) for reading.
+//! The other side only writes to the eventfd when it moves the ring out of that state while
+//! someone is waiting, so a busy transfer costs no syscalls at all.
+class SPSCRing
+{
+public:
+  explicit SPSCRing( uint64_t capacity );
+
+  uint64_t capacity() const { return capacity_; }
+  uint64_t bytes_buffered() const; //!< Safe to call from either side
+
+  //! \name Producer side
+  //!@{
+  uint64_t push( std::string_view data ); //!< Copy in as much of `data` as fits; returns bytes copied
+  void close();                           //!< Nothing more will be pushed (wakes the consumer)
+  uint64_t available_capacity() const;
+  void prepare_wait_for_space(); //!< Arm `space_event()` before polling it
+  FileDescriptor& space_event() { return space_event_; }
+
+  //! Has the consumer gone away?
+  bool reader_closed() const { return reader_closed_.load(); }
+  //!@}
+
+  //! \name Consumer side
+  //!@{
+  uint64_t pop( std::span<char> out ); //!< Copy out up to `out.size()` bytes; returns bytes copied
+  void close_reader();                 //!< Nothing more will be popped (wakes the producer)
+  void prepare_wait_for_data();        //!< Arm `data_event()` before polling it
+
+  //! The buffered bytes, in place: the run up to the end of the ring, then the part that wrapped
+  //! (empty unless the data wraps). They stay valid until `consume()` releases them to the producer.
+  std::array<std::string_view, 2> peek_regions() const;
+  void consume( uint64_t len ); //!< Drop the first `len` peeked bytes (wakes the producer if it waits)
+  FileDescriptor& data_event() { return data_event_; }
+
+  //! Has the producer closed the ring (and has everything been popped)?
+  bool is_closed() const { return closed_.load(); }
+  bool is_finished() const { return is_closed() and bytes_buffered() == 0; }
+  //!@}
+
+  //! Clear a fired event (call from the side that polls it)
+  static void drain( FileDescriptor& event );
+
+  //! Block the calling thread until `event` fires
+  static void wait( FileDescriptor& event );
+
+private:
+  static void notify( const FileDescriptor& event );
+
+  uint64_t capacity_;
+  RingStorage buffer_;
+
+  std::atomic<uint64_t> head_ { 0 }; //!< Bytes popped so far (written by the consumer)
+  std::atomic<uint64_t> tail_ { 0 }; //!< Bytes pushed so far (written by the producer)
+  std::atomic<bool> closed_ { false };
+  std::atomic<bool> reader_closed_ { false };
+
+  std::atomic<bool> reader_waiting_ { false };
+  std::atomic<bool> writer_waiting_ { false };
+
+  FileDescriptor data_event_;  //!< eventfd: "the ring is no longer empty"
+  FileDescriptor space_event_; //!< eventfd: "the ring is no longer full"
+};
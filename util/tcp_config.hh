@@ -1,10 +1,15 @@
 #pragma once
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "coalescing.hh"
+#include "congestion_control.hh"
+#include "reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 
 //! Config for TCP sender and receiver
@@ -15,11 +20,49 @@ public:
   static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr uint16_t PEER_MSS_DEFAULT = 536; //!< MSS to assume of a peer that doesn't send one (RFC 9293)
+  static constexpr size_t HEADERS_SIZE = 40;        //!< IPv4 and TCP headers, without options
+  static constexpr size_t OPTIONS_SIZE = 40;        //!< The most TCP options a header can carry
+  static constexpr uint8_t MAX_WINDOW_SHIFT = 14;   //!< Largest window-scale shift count (RFC 7323)
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
+  uint64_t rto_min_us = 200'000;           //!< Least retransmission timeout the RTT estimate may yield
+  uint64_t rto_max_ms = 60000;             //!< Greatest one (backing off after timeouts may exceed it)
+  uint64_t rto_granularity_us = 1000;      //!< Clock granularity G: the least the RTO sits above the SRTT
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+
+  //! Storage for the inbound and outbound streams (Mirrored lets peek() see every buffered byte;
+  //! Chunked keeps pushed strings as-is instead of copying them into the stream; Pooled borrows
+  //! memory from BufferPool::global() only while bytes are buffered)
+  ByteStream::Storage stream_storage = ByteStream::Storage::Ring;
+
+  //! Where the receiver keeps out-of-order bytes (Direct writes them straight into the inbound
+  //! stream's free space; it needs Ring or Mirrored storage and falls back to Buffered otherwise)
+  Reassembler::Placement reassembly = Reassembler::Placement::Buffered;
+
+  //! Out-of-order memory limit shared with other connections (only those run by the same thread)
+  std::shared_ptr<ReassemblyBudget> reassembly_budget {};
+
+  //! What limits the sender's bytes in flight besides the receiver's window
+  CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::NewReno;
+
+  //! Whether short segments wait for more bytes while data is in flight
+  Coalescing coalescing = Coalescing::Nagle;
+  bool nodelay = false; //!< Like TCP_NODELAY: send short segments at once, whatever `coalescing` says
+
+  //! MTU of our link: we advertise an MSS of `mtu` less the headers, and our segments' payloads leave
+  //! room within it for the options they carry (e.g. SACK blocks)
+  size_t mtu = 1500;
+
+  //! Packetization-layer path MTU discovery (RFC 4821): start at MAX_PAYLOAD_SIZE and probe for larger
+  //! segments, up to what both ends accept (without it, send segments as large as that at once)
+  bool mtu_probing = true;
+
+  //! Window scaling (RFC 7323): offer it on the SYN, so windows can exceed 64 KB if the peer offers it
+  //! too (the shift is the least that lets the window cover recv_capacity)
+  bool window_scaling = true;
 };
 
 //! Config for classes derived from FdAdapter
@@ -3,13 +3,16 @@
 #include "byte_stream.hh"
 #include "eventloop.hh"
 #include "file_descriptor.hh"
+#include "mapped_file.hh"
 #include "socket.hh"
+#include "spsc_ring.hh"
 #include "tcp_config.hh"
 #include "tcp_peer.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -36,6 +39,26 @@ public:
   //! When a connected socket is destructed, it will send a RST
   ~TCPMinnowSocket();
 
+  //! \name
+  //! In-process mode: the owner thread and the TCPPeer thread exchange bytes through a pair of
+  //! shared-memory rings instead of the AF_UNIX socket pair, which saves two kernel copies and
+  //! two syscalls per chunk. Call use_shared_memory() before connect() or listen_and_accept(),
+  //! then use these methods instead of reading and writing the socket's file descriptor.
+
+  //!@{
+  void use_shared_memory();
+  size_t write_shared( std::string_view data ); //!< Blocks until at least one byte is written
+  void read_shared( std::string& buffer );      //!< Blocks until some bytes arrive; sets eof() at the end
+  void shutdown_shared_write();                 //!< Signal that the owner will write nothing more
+  //!@}
+
+  //! File mode: send the contents of `file` (then end the outbound stream) instead of the bytes the
+  //! owner writes to the socket. The TCPPeer thread pushes the mapped pages into the outbound stream
+  //! by reference, so a TCPConfig with Chunked stream storage avoids copying them before they are
+  //! sliced into segments. Call before connect() or listen_and_accept(); the owner still reads the
+  //! inbound stream from the socket as usual.
+  void send_file( std::shared_ptr<const MappedFile> file );
+
   //! \name
   //! This object cannot be safely moved or copied, since it is in use by two threads simultaneously
 
@@ -66,6 +89,24 @@ private:
   //! Stream socket for reads and writes between owner and TCP thread
   LocalStreamSocket _thread_data;
 
+  //! In-process mode: rings for bytes from the owner to TCPPeer and from TCPPeer to the owner
+  bool _shared_memory { false };
+  std::unique_ptr<SPSCRing> _outbound_ring {};
+  std::unique_ptr<SPSCRing> _inbound_ring {};
+
+  //! Add the event loop rules that move bytes through the shared-memory rings
+  void _add_shared_memory_rules();
+
+  //! File mode: the file to send, and how much of it has been pushed to the outbound stream
+  std::shared_ptr<const MappedFile> _outbound_file {};
+  uint64_t _outbound_file_offset {};
+
+  //! Add the event loop rule that reads the owner's bytes from the socket pair
+  void _add_pipe_input_rule();
+
+  //! Debugging output: how the inbound stream was reassembled
+  void _print_reassembly_counters() const;
+
   //! Set up the TCPPeer and the event loop
   void _initialize_TCP( const TCPConfig& config );
 
@@ -94,6 +135,10 @@ private:
   bool _outbound_shutdown { false }; //!< Has the owner shut down the outbound data to the TCP connection?
 
   bool _fully_acked { false }; //!< Has the outbound data been fully acknowledged by the peer?
+
+  bool _outbound_has_space { true }; //!< Outbound stream has room (set by its low-watermark callback)
+
+  bool _inbound_has_data { false }; //!< Inbound stream has data (set by its watermark callback)
 };
 
 using TCPOverIPv4MinnowSocket = TCPMinnowSocket<TCPOverIPv4OverTunFdAdapter>;
@@ -128,6 +173,8 @@ public:
   {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.stream_storage = ByteStream::Storage::Mirrored;
+    tcp_config.reassembly = Reassembler::Placement::Direct;
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = { "169.254.144.9", std::to_string( uint16_t( std::random_device()() ) ) };
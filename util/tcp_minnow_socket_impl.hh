@@ -4,11 +4,13 @@
 #include "parser.hh"
 #include "tun.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -17,18 +19,18 @@
 
 static constexpr size_t TCP_TICK_MS = 10;
 
-inline uint64_t timestamp_ms()
+inline uint64_t timestamp_us()
 {
   static_assert( std::is_same<std::chrono::steady_clock::duration, std::chrono::nanoseconds>::value );
 
-  return std::chrono::steady_clock::now().time_since_epoch().count() / 1000000;
+  return std::chrono::steady_clock::now().time_since_epoch().count() / 1000;
 }
 
 //! \param[in] condition is a function returning true if loop should continue
 template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition )
 {
-  auto base_time = timestamp_ms();
+  auto base_time = timestamp_us();
   while ( condition() ) {
     auto ret = _eventloop.wait_next_event( TCP_TICK_MS );
     if ( ret == EventLoop::Result::Exit or _abort ) {
@@ -40,9 +42,9 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
     }
 
     if ( _tcp.value().active() ) {
-      const auto next_time = timestamp_ms();
-      _tcp.value().tick( next_time - base_time, [&]( auto x ) { _datagram_adapter.write( x ); } );
-      _datagram_adapter.tick( next_time - base_time );
+      const auto next_time = timestamp_us();
+      _tcp.value().tick_us( next_time - base_time, [&]( auto x ) { _datagram_adapter.write( x ); } );
+      _datagram_adapter.tick( next_time / 1000 - base_time / 1000 );
       base_time = next_time;
     }
   }
@@ -91,7 +93,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       }
 
       // debugging output:
-      if ( _thread_data.eof() and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
+      if ( _outbound_shutdown and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
         std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
                   << " has been fully acknowledged.\n";
         _fully_acked = true;
@@ -99,16 +101,110 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     },
     [&] { return _tcp->active(); } );
 
-  // rule 2: read from pipe into outbound buffer
+  if ( _shared_memory ) {
+    _outbound_ring = std::make_unique<SPSCRing>( config.send_capacity );
+    _inbound_ring = std::make_unique<SPSCRing>( config.recv_capacity );
+    _add_shared_memory_rules();
+    return;
+  }
+
+  // Arm rules 2 and 3 on watermark edges: stop reading from the pipe when the outbound stream fills and
+  // resume once an eighth of it has been acknowledged; write to the pipe only while there is inbound data.
+  _tcp->outbound_writer().on_capacity_above( std::max<uint64_t>( config.send_capacity / 8, 1 ),
+                                             [&] { _outbound_has_space = true; } );
+  _tcp->inbound_reader().on_buffered_above( 1, [&] { _inbound_has_data = true; } );
+
+  // rule 2: read from pipe into outbound buffer (or, in file mode, from the mapped file)
+  if ( _outbound_file ) {
+    _eventloop.add_rule(
+      "push file to TCPPeer",
+      [&] {
+        _outbound_file_offset += _tcp->outbound_writer().push_file( _outbound_file, _outbound_file_offset );
+        _outbound_has_space = _tcp->outbound_writer().available_capacity() > 0;
+
+        if ( _outbound_file_offset == _outbound_file->size() ) {
+          _tcp->outbound_writer().close();
+          _outbound_shutdown = true;
+          _outbound_file.reset();
+
+          // debugging output:
+          std::cerr << "DEBUG: minnow outbound file to " << _datagram_adapter.config().destination.to_string()
+                    << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
+                    << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" )
+                    << " still in flight).\n";
+        }
+
+        _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+      },
+      [&] { return ( _tcp->active() ) and ( not _outbound_shutdown ) and _outbound_has_space; } );
+  } else {
+    _add_pipe_input_rule();
+  }
+
+  // rule 3: read from inbound buffer into pipe
+  _eventloop.add_rule(
+    "read bytes from inbound stream",
+    _thread_data,
+    Direction::Out,
+    [&] {
+      Reader& inbound = _tcp->inbound_reader();
+      // Write from the inbound_stream into
+      // the pipe, handling the possibility of a partial
+      // write (i.e., only pop what was actually written).
+      if ( inbound.bytes_buffered() ) {
+        const auto bytes_written = _thread_data.write( inbound.peek_iov() );
+        inbound.pop( bytes_written );
+      }
+      _inbound_has_data = inbound.bytes_buffered() > 0;
+
+      if ( inbound.is_finished() or inbound.has_error() ) {
+        _thread_data.shutdown( SHUT_WR );
+        _inbound_shutdown = true;
+
+        // debugging output:
+        std::cerr << "DEBUG: minnow inbound stream from " << _datagram_adapter.config().destination.to_string()
+                  << " finished " << ( inbound.has_error() ? "uncleanly.\n" : "cleanly.\n" );
+        _print_reassembly_counters();
+      }
+    },
+    [&] {
+      return _inbound_has_data
+             or ( ( _tcp->inbound_reader().is_finished() or _tcp->inbound_reader().has_error() )
+                  and not _inbound_shutdown );
+    },
+    [&] {},
+    [&] {
+      std::cerr << "DEBUG: minnow inbound stream had error.\n";
+      _tcp->inbound_reader().set_error();
+    } );
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_print_reassembly_counters() const
+{
+  const auto& c = _tcp->receiver().reassembler_counters();
+  std::cerr << "DEBUG: minnow reassembly: " << c.inserts << " inserts, " << c.duplicate_bytes
+            << " duplicate bytes, " << c.beyond_capacity_bytes << " bytes beyond capacity, " << c.evictions
+            << " evictions, peak " << c.peak_bytes_pending << " bytes pending, " << c.holes_filled
+            << " holes filled";
+  if ( c.holes_filled ) {
+    std::cerr << " (mean " << c.fill_inserts_total / c.holes_filled << ", max " << c.fill_inserts_max
+              << " inserts to fill)";
+  }
+  std::cerr << ".\n";
+}
+
+//! Rule 2: read from the pipe into the outbound buffer
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_add_pipe_input_rule()
+{
   _eventloop.add_rule(
     "push bytes to TCPPeer",
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      _tcp->outbound_writer().push_from_fd( _thread_data );
+      _outbound_has_space = _tcp->outbound_writer().available_capacity() > 0;
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -124,8 +220,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
     },
     [&] {
-      return ( _tcp->active() ) and ( not _outbound_shutdown )
-             and ( _tcp->outbound_writer().available_capacity() > 0 );
+      return ( _tcp->active() ) and ( not _outbound_shutdown ) and _outbound_has_space;
     },
     [&] {
       _tcp->outbound_writer().close();
@@ -135,44 +230,194 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       std::cerr << "DEBUG: minnow outbound stream had error.\n";
       _tcp->outbound_writer().set_error();
     } );
+}
 
-  // rule 3: read from inbound buffer into pipe
+//! Rules 2 and 3 for in-process mode. Each direction is driven by its ring's eventfd, so it runs once per
+//! wakeup and the eventfd is only armed when the ring is empty (or full). The owner's pushes and pops
+//! then only signal on the transition out of that state, and a busy transfer makes no syscalls.
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_add_shared_memory_rules()
+{
+  // Wake rule 2 when an eighth of the outbound stream has been acknowledged (the eventfd fires at once
+  // if the owner filled the ring meanwhile), and rule 3 when the inbound stream gets data.
+  _tcp->outbound_writer().on_capacity_above( std::max<uint64_t>( _outbound_ring->capacity() / 8, 1 ), [&] {
+    _outbound_has_space = true;
+    _outbound_ring->prepare_wait_for_data();
+  } );
+  _tcp->inbound_reader().on_buffered_above( 1, [&] {
+    _inbound_has_data = true;
+    _inbound_ring->prepare_wait_for_space();
+  } );
+  _outbound_ring->prepare_wait_for_data();
+
+  // rule 2: read from the outbound ring into the outbound buffer
   _eventloop.add_rule(
-    "read bytes from inbound stream",
-    _thread_data,
-    Direction::Out,
+    "push bytes to TCPPeer from shared memory",
+    _outbound_ring->data_event(),
+    Direction::In,
     [&] {
-      Reader& inbound = _tcp->inbound_reader();
-      // Write from the inbound_stream into
-      // the pipe, handling the possibility of a partial
-      // write (i.e., only pop what was actually written).
-      if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
-        inbound.pop( bytes_written );
+      SPSCRing::drain( _outbound_ring->data_event() );
+
+      Writer& outbound = _tcp->outbound_writer();
+      // copy straight from the ring into the stream's free space, then hand the room back to the owner
+      while ( _outbound_ring->bytes_buffered() and outbound.available_capacity() ) {
+        for ( const std::string_view region : _outbound_ring->peek_regions() ) {
+          const uint64_t len = std::min<uint64_t>( region.size(), outbound.available_capacity() );
+          outbound.push_view( region.substr( 0, len ) );
+          _outbound_ring->consume( len );
+        }
       }
+      _outbound_has_space = outbound.available_capacity() > 0;
 
-      if ( inbound.is_finished() or inbound.has_error() ) {
-        _thread_data.shutdown( SHUT_WR );
-        _inbound_shutdown = true;
+      if ( _outbound_ring->is_finished() ) {
+        outbound.close();
+        _outbound_shutdown = true;
 
         // debugging output:
-        std::cerr << "DEBUG: minnow inbound stream from " << _datagram_adapter.config().destination.to_string()
-                  << " finished " << ( inbound.has_error() ? "uncleanly.\n" : "cleanly.\n" );
+        std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
+                  << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
+                  << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" )
+                  << " still in flight).\n";
+      } else if ( _outbound_has_space ) {
+        // the ring is empty: sleep until the owner pushes
+        _outbound_ring->prepare_wait_for_data();
       }
+
+      _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
     },
+    [&] { return _tcp->active() and ( not _outbound_shutdown ) and _outbound_has_space; } );
+
+  // rule 3: read from inbound buffer into the inbound ring
+  _eventloop.add_rule(
+    "read bytes from inbound stream into shared memory",
+    _inbound_ring->space_event(),
+    Direction::In,
     [&] {
-      return _tcp->inbound_reader().bytes_buffered()
-             or ( ( _tcp->inbound_reader().is_finished() or _tcp->inbound_reader().has_error() )
-                  and not _inbound_shutdown );
+      SPSCRing::drain( _inbound_ring->space_event() );
+
+      Reader& inbound = _tcp->inbound_reader();
+      for ( const auto region : inbound.peek_iov() ) {
+        // if the owner has stopped reading, just discard
+        const auto bytes_written
+          = _inbound_ring->reader_closed() ? region.size() : _inbound_ring->push( region );
+        inbound.pop( bytes_written );
+        if ( bytes_written < region.size() ) {
+          break;
+        }
+      }
+      _inbound_has_data = inbound.bytes_buffered() > 0;
+
+      if ( _inbound_has_data ) {
+        // the ring is full: sleep until the owner pops
+        _inbound_ring->prepare_wait_for_space();
+      }
     },
-    [&] {},
+    [&] { return _inbound_has_data and not _inbound_shutdown; } );
+
+  // The end of the inbound stream comes with no data to wake rule 3, so close the ring from here
+  // (this fires once).
+  _eventloop.add_rule(
+    "close shared memory to owner",
     [&] {
-      std::cerr << "DEBUG: minnow inbound stream had error.\n";
-      _tcp->inbound_reader().set_error();
+      const Reader& inbound = _tcp->inbound_reader();
+      _inbound_ring->close();
+      _inbound_shutdown = true;
+
+      // debugging output:
+      std::cerr << "DEBUG: minnow inbound stream from " << _datagram_adapter.config().destination.to_string()
+                << " finished " << ( inbound.has_error() ? "uncleanly.\n" : "cleanly.\n" );
+      _print_reassembly_counters();
+    },
+    [&] {
+      const Reader& inbound = _tcp->inbound_reader();
+      return ( inbound.is_finished() or inbound.has_error() ) and not _inbound_shutdown;
     } );
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::send_file( std::shared_ptr<const MappedFile> file )
+{
+  if ( _tcp ) {
+    throw std::runtime_error( "send_file() with TCPConnection already initialized" );
+  }
+  if ( _shared_memory ) {
+    throw std::runtime_error( "send_file() is not supported in shared-memory mode" );
+  }
+  _outbound_file = std::move( file );
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::use_shared_memory()
+{
+  if ( _tcp ) {
+    throw std::runtime_error( "use_shared_memory() with TCPConnection already initialized" );
+  }
+  if ( _outbound_file ) {
+    throw std::runtime_error( "use_shared_memory() is not supported in file mode" );
+  }
+  _shared_memory = true;
+}
+
+//! \returns the number of bytes written (at least one, unless `data` is empty)
+template<TCPDatagramAdapter AdaptT>
+size_t TCPMinnowSocket<AdaptT>::write_shared( std::string_view data )
+{
+  if ( not _outbound_ring ) {
+    throw std::runtime_error( "write_shared() without use_shared_memory() and connect()/listen_and_accept()" );
+  }
+
+  while ( not data.empty() ) {
+    if ( _outbound_ring->reader_closed() ) {
+      throw std::runtime_error( "write_shared() after TCP connection finished" );
+    }
+    if ( const auto bytes_written = _outbound_ring->push( data ) ) {
+      register_write();
+      return bytes_written;
+    }
+    _outbound_ring->prepare_wait_for_space();
+    SPSCRing::wait( _outbound_ring->space_event() );
+  }
+  return 0;
+}
+
+//! \param[out] buffer receives the bytes read (if empty on entry, it is first sized to the default read size)
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::read_shared( std::string& buffer )
+{
+  if ( not _inbound_ring ) {
+    throw std::runtime_error( "read_shared() without use_shared_memory() and connect()/listen_and_accept()" );
+  }
+
+  if ( buffer.empty() ) {
+    buffer.resize( kReadBufferSize );
+  }
+
+  while ( true ) {
+    // check for the end first: once the ring is closed, the pop below sees everything that was pushed
+    const bool closed = _inbound_ring->is_closed();
+    if ( const auto bytes_read = _inbound_ring->pop( buffer ) ) {
+      register_read();
+      buffer.resize( bytes_read );
+      return;
+    }
+    if ( closed ) {
+      set_eof();
+      buffer.clear();
+      return;
+    }
+    _inbound_ring->prepare_wait_for_data();
+    SPSCRing::wait( _inbound_ring->data_event() );
+  }
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::shutdown_shared_write()
+{
+  if ( _outbound_ring ) {
+    _outbound_ring->close();
+  }
+}
+
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
 //! \param[in] type is the type of AF_UNIX sockets to create (e.g., SOCK_SEQPACKET)
 //! \returns a std::pair of connected sockets
@@ -210,6 +455,10 @@ template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::wait_until_closed()
 {
   shutdown( SHUT_RDWR );
+  if ( _outbound_ring ) {
+    _outbound_ring->close();
+    _inbound_ring->close_reader();
+  }
   if ( _tcp_thread.joinable() ) {
     std::cerr << "DEBUG: minnow waiting for clean shutdown... ";
     _tcp_thread.join();
@@ -282,6 +531,11 @@ void TCPMinnowSocket<AdaptT>::_tcp_main()
     }
     _tcp_loop( [] { return true; } );
     shutdown( SHUT_RDWR );
+    if ( _inbound_ring ) {
+      // wake up an owner blocked on the rings
+      _inbound_ring->close();
+      _outbound_ring->close_reader();
+    }
     if ( not _tcp.value().active() ) {
       std::cerr << "DEBUG: minnow TCP connection finished "
                 << ( _tcp->inbound_reader().has_error() ? "uncleanly.\n" : "cleanly.\n" );
@@ -7,6 +7,8 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <optional>
 
@@ -27,11 +29,17 @@ public:
   using TransmitFunction = std::function<void( TCPMessage )>;
 
   /* Passthrough methods */
-  void push( const TransmitFunction& transmit ) { sender_.push( make_send( transmit ) ); }
-  void tick( uint64_t t, const TransmitFunction& transmit )
+  void push( const TransmitFunction& transmit )
+  {
+    sender_.set_options_size( sack_option_size() );
+    sender_.push( make_send( transmit ) );
+  }
+  void tick( uint64_t t, const TransmitFunction& transmit ) { tick_us( t * 1000, transmit ); }
+  void tick_us( uint64_t t, const TransmitFunction& transmit )
   {
     cumulative_time_ += t;
-    sender_.tick( t, make_send( transmit ) );
+    sender_.set_options_size( sack_option_size() );
+    sender_.tick_us( t, make_send( transmit ) );
   }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
 
@@ -42,7 +50,7 @@ public:
     const bool sender_active = sender_.sequence_numbers_in_flight() or not sender_.reader().is_finished();
     const bool receiver_active = not receiver_.writer().is_closed();
     const bool lingering
-      = linger_after_streams_finish_ and ( cumulative_time_ < time_of_last_receipt_ + 10UL * cfg_.rt_timeout );
+      = linger_after_streams_finish_ and ( cumulative_time_ < time_of_last_receipt_ + 10'000UL * cfg_.rt_timeout );
 
     return ( not any_errors ) and ( sender_active or receiver_active or lingering );
   }
@@ -65,15 +73,30 @@ public:
     need_send_ |= ( our_ackno.has_value() and msg.sender.seqno + 1 == our_ackno.value() );
 
     // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
-    if ( receiver_.writer().is_closed() and not sender_.reader().is_finished() ) {
+    if ( receiver_.writer().is_closed() and not sender_.finished_sending() ) {
       linger_after_streams_finish_ = false;
     }
 
+    // The peer's SYN says how large a segment it accepts, and whether it scales its windows.
+    const bool peer_SYN = msg.sender.SYN and not has_ackno();
+    const auto peer_window_scale = msg.sender.window_scale;
+    if ( peer_SYN ) {
+      negotiate_mss( msg.sender.MSS.value_or( TCPConfig::PEER_MSS_DEFAULT ) );
+      window_scaling_ = cfg_.window_scaling and peer_window_scale.has_value();
+    }
+
     // Give incoming TCPSenderMessage to receiver.
+    const bool with_data = msg.sender.sequence_length() > 0;
     receiver_.receive( std::move( msg.sender ) );
 
     // Give incoming TCPReceiverMessage to sender.
-    sender_.receive( msg.receiver );
+    sender_.receive( msg.receiver, with_data );
+
+    // Scaling applies to the windows after the SYNs' (RFC 7323), if both SYNs carried the option.
+    if ( peer_SYN and window_scaling_ ) {
+      sender_.set_window_shift( std::min( *peer_window_scale, TCPConfig::MAX_WINDOW_SHIFT ) );
+      receiver_.set_window_shift( window_shift() );
+    }
 
     // Send reply if needed.
     push( transmit );
@@ -88,19 +111,76 @@ public:
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity, cfg_.stream_storage },
+                      cfg_.isn,
+                      cfg_.rt_timeout,
+                      CongestionControl::make( cfg_.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE ),
+                      TCPSender::RTOBounds { cfg_.rto_min_us, cfg_.rto_max_ms * 1000, cfg_.rto_granularity_us },
+                      cfg_.nodelay ? Coalescing::Off : cfg_.coalescing };
+  TCPReceiver receiver_ {
+    Reassembler { ByteStream { cfg_.recv_capacity, cfg_.stream_storage }, cfg_.reassembly, cfg_.reassembly_budget } };
 
   bool need_send_ {};
+  bool window_scaling_ { cfg_.window_scaling }; // offered, then (after the peer's SYN) in effect
 
   void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
   {
     TCPMessage msg { sender_message, receiver_.send() };
+
+    // A segment sized before the receiver had SACK blocks to send (a retransmission, or a path MTU
+    // probe) carries only as many as fit in the MSS
+    const uint64_t room = std::max( sender_.mss(), msg.sender.payload.size() ) - msg.sender.payload.size();
+    if ( msg.receiver.sack.size() * 8 + 4 > room ) {
+      msg.receiver.sack.resize( room > 4 ? ( room - 4 ) / 8 : 0 );
+    }
+
+    if ( msg.sender.SYN ) {
+      msg.sender.MSS = advertised_mss();
+      if ( window_scaling_ ) {
+        msg.sender.window_scale = window_shift();
+      }
+      msg.receiver.window_size = receiver_.window_size( true );
+    }
     transmit( std::move( msg ) );
     need_send_ = false;
   }
 
+  uint16_t advertised_mss() const
+  {
+    return static_cast<uint16_t>( std::min<size_t>( cfg_.mtu - TCPConfig::HEADERS_SIZE, UINT16_MAX ) );
+  }
+
+  // The SACK option our segments carry now: two NOPs, kind and length, then 8 bytes a block
+  uint64_t sack_option_size() const
+  {
+    const size_t blocks = receiver_.send().sack.size();
+    return blocks ? 4 + 8 * blocks : 0;
+  }
+
+  // The least shift that lets a window cover the receive capacity
+  uint8_t window_shift() const
+  {
+    uint8_t shift = 0;
+    while ( shift < TCPConfig::MAX_WINDOW_SHIFT and ( cfg_.recv_capacity >> shift ) > UINT16_MAX ) {
+      ++shift;
+    }
+    return shift;
+  }
+
+  // Segments carry no more than either end accepts; with probing, they start at MAX_PAYLOAD_SIZE and
+  // the sender looks for what the path between carries. The MSS doesn't count TCP options (RFC 9293):
+  // the sender shrinks each segment's payload by the options it carries (see sack_option_size()).
+  void negotiate_mss( uint16_t peer_mss )
+  {
+    const uint64_t largest = std::max<uint64_t>( std::min( peer_mss, advertised_mss() ), 1 );
+    if ( cfg_.mtu_probing ) {
+      sender_.set_mss( std::min<uint64_t>( TCPConfig::MAX_PAYLOAD_SIZE, largest ), largest );
+    } else {
+      sender_.set_mss( largest );
+    }
+  }
+
   bool linger_after_streams_finish_ { true }; // one peer may need to linger to make sure all closure conditions met
-  uint64_t cumulative_time_ {};
+  uint64_t cumulative_time_ {}; // microseconds
   uint64_t time_of_last_receipt_ {};
 };
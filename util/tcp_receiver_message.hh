@@ -2,7 +2,9 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
@@ -14,14 +16,31 @@
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    the <cstdint> header), in units of 2^shift bytes once window scaling is in effect (RFC 7323).
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) The SACK blocks (RFC 2018): ranges of sequence numbers past the ackno that the TCP receiver already
+ *    holds, the one that changed most recently first. Sent only if the peer's SYN permitted SACK.
+ *
+ * 5) The ECE (ECN-Echo) flag (RFC 3168): the TCP receiver has seen a congestion-experienced mark.
  */
 
+struct SACKBlock
+{
+  Wrap32 left { 0 };  // first sequence number of the block
+  Wrap32 right { 0 }; // sequence number just after the block
+
+  bool operator==( const SACKBlock& other ) const = default;
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the TCP header's options
+
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
   bool RST {};
+  std::vector<SACKBlock> sack {};
+  bool ECE {};
 };
@@ -4,7 +4,16 @@
 
 #include <cstddef>
 
-static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
+static constexpr uint32_t TCPHeaderMinLen = 5;  // 32-bit words
+static constexpr uint32_t TCPOptionsMaxLen = 40; // bytes
+
+// TCP option kinds
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNOP = 1;
+static constexpr uint8_t TCPOptionMSS = 2;
+static constexpr uint8_t TCPOptionWindowScale = 3;
+static constexpr uint8_t TCPOptionSACKPermitted = 4;
+static constexpr uint8_t TCPOptionSACK = 5;
 
 using namespace std;
 
@@ -39,6 +48,7 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
     message.receiver.ackno.reset(); // no ACK
   }
 
+  message.receiver.ECE = octet & 0b0100'0000;
   message.sender.RST = message.receiver.RST = octet & 0b0000'0100;
   message.sender.SYN = octet & 0b0000'0010;
   message.sender.FIN = octet & 0b0000'0001;
@@ -47,15 +57,67 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  parse_options( parser, data_offset * 4 - TCPHeaderMinLen * 4 );
 
   parser.all_remaining( message.sender.payload );
 }
 
+// Parse the options we know and skip the rest
+void TCPSegment::parse_options( Parser& parser, uint32_t length )
+{
+  uint8_t kind {};
+  uint8_t option_length {};
+  uint32_t raw32 {};
+  uint16_t raw16 {};
+  uint8_t raw8 {};
+
+  while ( length > 0 and not parser.has_error() ) {
+    parser.integer( kind );
+    --length;
+    if ( kind == TCPOptionEnd ) {
+      break;
+    }
+    if ( kind == TCPOptionNOP ) {
+      continue;
+    }
+
+    parser.integer( option_length );
+    if ( option_length < 2 or option_length - 1U > length ) {
+      parser.set_error();
+      return;
+    }
+    length -= option_length - 1;
+    const uint32_t body_length = option_length - 2;
+
+    if ( kind == TCPOptionMSS and body_length == 2 ) {
+      parser.integer( raw16 );
+      message.sender.MSS = raw16;
+    } else if ( kind == TCPOptionWindowScale and body_length == 1 ) {
+      parser.integer( raw8 );
+      message.sender.window_scale = raw8;
+    } else if ( kind == TCPOptionSACKPermitted and body_length == 0 ) {
+      message.sender.SACK_permitted = true;
+    } else if ( kind == TCPOptionSACK and body_length % 8 == 0 ) {
+      for ( uint32_t i = 0; i < body_length; i += 8 ) {
+        SACKBlock block;
+        parser.integer( raw32 );
+        block.left = Wrap32 { raw32 };
+        parser.integer( raw32 );
+        block.right = Wrap32 { raw32 };
+        message.receiver.sack.push_back( block );
+      }
+    } else {
+      parser.remove_prefix( body_length );
+    }
+  }
+
+  parser.remove_prefix( length ); // anything after the end of the option list
+}
+
 class Wrap32Serializable : public Wrap32
 {
 public:
@@ -68,17 +130,74 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  const string options = serialize_options();
+  serializer.integer( static_cast<uint8_t>( ( TCPHeaderMinLen + options.size() / 4 ) << 4 ) ); // data offset
   const bool reset = message.sender.RST or message.receiver.RST;
-  const uint8_t flags = ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
+  const uint8_t flags = ( message.receiver.ECE ? 0b0100'0000U : 0 )
+                        | ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender.SYN ? 0b0000'0010U : 0 ) | ( message.sender.FIN ? 0b0000'0001U : 0 );
   serializer.integer( flags );
   serializer.integer( message.receiver.window_size );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
+  serializer.buffer( options );
   serializer.buffer( message.sender.payload );
 }
 
+// The options, padded with NOPs to a multiple of 4 bytes
+string TCPSegment::serialize_options() const
+{
+  Serializer options;
+  uint32_t length = 0;
+
+  if ( message.sender.SYN and message.sender.MSS.has_value() ) {
+    options.integer( TCPOptionMSS );
+    options.integer( uint8_t { 4 } );
+    options.integer( *message.sender.MSS );
+    length += 4;
+  }
+
+  if ( message.sender.SYN and message.sender.window_scale.has_value() ) {
+    options.integer( TCPOptionNOP );
+    options.integer( TCPOptionWindowScale );
+    options.integer( uint8_t { 3 } );
+    options.integer( *message.sender.window_scale );
+    length += 4;
+  }
+
+  if ( message.sender.SYN and message.sender.SACK_permitted ) {
+    options.integer( TCPOptionNOP );
+    options.integer( TCPOptionNOP );
+    options.integer( TCPOptionSACKPermitted );
+    options.integer( uint8_t { 2 } );
+    length += 4;
+  }
+
+  // as many SACK blocks as fit
+  const size_t sack_blocks = min<size_t>( message.receiver.sack.size(), ( TCPOptionsMaxLen - length - 4 ) / 8 );
+  if ( message.receiver.ackno.has_value() and sack_blocks > 0 ) {
+    options.integer( TCPOptionNOP );
+    options.integer( TCPOptionNOP );
+    options.integer( TCPOptionSACK );
+    options.integer( static_cast<uint8_t>( 2 + sack_blocks * 8 ) );
+    for ( size_t i = 0; i < sack_blocks; ++i ) {
+      options.integer( Wrap32Serializable { message.receiver.sack[i].left }.raw_value() );
+      options.integer( Wrap32Serializable { message.receiver.sack[i].right }.raw_value() );
+    }
+  }
+
+  string ret;
+  for ( const auto& buf : options.output() ) {
+    ret.append( buf );
+  }
+  return ret;
+}
+
+size_t TCPSegment::header_length() const
+{
+  return TCPHeaderMinLen * 4 + serialize_options().size();
+}
+
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
 {
   udinfo.cksum = 0;
@@ -20,4 +20,11 @@ struct TCPSegment
   void serialize( Serializer& serializer ) const;
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // Length of the serialized header, options included, in bytes
+  size_t header_length() const;
+
+private:
+  void parse_options( Parser& parser, uint32_t length );
+  std::string serialize_options() const;
 };
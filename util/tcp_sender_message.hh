@@ -1,8 +1,10 @@
 #pragma once
 
+#include "buffer_slice.hh"
 #include "wrapping_integers.hh"
 
-#include <string>
+#include <cstdint>
+#include <optional>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
@@ -15,11 +17,20 @@
  * 2) The SYN flag. If set, this segment is the beginning of the byte stream, and the seqno field
  *    contains the Initial Sequence Number (ISN) -- the zero point.
  *
- * 3) The payload: a substring (possibly empty) of the byte stream.
+ * 3) The payload: a substring (possibly empty) of the byte stream, sharing the buffer it was read or parsed
+ *    from.
  *
  * 4) The FIN flag. If set, the payload represents the ending of the byte stream.
  *
  * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 6) The SACK-permitted flag. Only meaningful with SYN: the sender can make use of SACK blocks (RFC 2018).
+ *
+ * 7) The maximum segment size (MSS). Only meaningful with SYN: the largest payload the sender is willing to
+ *    receive in one segment. Without it, the peer must assume 536 bytes (RFC 9293).
+ *
+ * 8) The window-scale shift count. Only meaningful with SYN: the windows the sender advertises after the
+ *    SYNs are in units of 2^shift bytes (RFC 7323), if both SYNs carried one.
  */
 
 struct TCPSenderMessage
@@ -27,11 +38,17 @@ struct TCPSenderMessage
   Wrap32 seqno { 0 };
 
   bool SYN {};
-  std::string payload {};
+  BufferSlice payload {};
   bool FIN {};
 
   bool RST {};
 
+  bool SACK_permitted {};
+
+  std::optional<uint16_t> MSS {};
+
+  std::optional<uint8_t> window_scale {};
+
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
 };
@@ -9,9 +9,9 @@ optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
   strs.front().resize( IPv4Header::LENGTH );
   _tun.read( strs );
 
+  // the datagram's payload (and so the TCP payload) stays in the buffers it was read into
   InternetDatagram ip_dgram;
-  const vector<string> buffers = { strs.at( 0 ), strs.at( 1 ) };
-  if ( parse( ip_dgram, buffers ) ) {
+  if ( parse( ip_dgram, to_slices( std::move( strs ) ) ) ) {
     return unwrap_tcp_in_ip( ip_dgram );
   }
   return {};